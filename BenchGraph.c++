@@ -0,0 +1,555 @@
+// -----------------------------
+// projects/graph/BenchGraph.c++
+// Copyright (C) 2014
+// Glenn P. Downing
+// -----------------------------
+
+/*
+To compile the benchmark:
+    % g++ -O2 -DNDEBUG -pedantic -std=c++11 -Wall BenchGraph.c++ -o BenchGraph -lpthread
+
+To run the benchmark:
+    % BenchGraph suite                   // Graph and BasicGraph<uint32_t> against boost::adjacency_list, scales 10, 13, and 16, as JSON
+    % BenchGraph suite 10 12 14          // chosen scales
+    % BenchGraph lookup                  // edge() and add_edges on 1e4, 1e6, and 1e7 edges
+    % BenchGraph lookup 10000 1000000    // chosen sizes
+    % BenchGraph concurrent              // add_edge on 1e6 edges from 1, 2, 4, and 8 threads, against a Graph behind a mutex
+    % BenchGraph concurrent 16           // chosen thread counts
+    % BenchGraph intersect               // sorted-list intersection kernels on lists of 16, 256, and 4096, and triangles of R-MAT 16
+    % BenchGraph intersect 64 1024       // chosen list sizes
+
+The suite runs every graph type on R-MAT, Erdos-Renyi, and grid graphs of 2^scale vertices and about
+16 * 2^scale edges. Each case runs in its own child process, so that its peak resident set is its own.
+Any other mode, or none, prints the usage and exits with 2.
+*/
+
+// --------
+// includes
+// --------
+
+#include <algorithm> // find
+#include <atomic>    // atomic
+#include <chrono>    // steady_clock
+#include <cmath>     // isfinite
+#include <cstdlib>   // atol
+#include <cstring>   // strcmp
+#include <iostream>  // cout, endl
+#include <random>    // mt19937
+#include <mutex>     // mutex
+#include <sstream>   // ostringstream
+#include <string>    // string
+#include <thread>    // thread
+#include <utility>   // make_pair, pair
+#include <vector>    // vector
+
+#include <sys/resource.h> // getrusage
+#include <sys/wait.h>     // waitpid
+#include <unistd.h>       // fork
+
+#include "boost/graph/adjacency_list.hpp" // adjacency_list
+
+#include "Graph.h"
+
+// -------
+// seconds
+// -------
+
+typedef std::chrono::steady_clock clock_type;
+
+double seconds (clock_type::time_point b, clock_type::time_point e) {
+    return std::chrono::duration<double>(e - b).count();}
+
+// ------
+// random
+// ------
+
+/**
+ * @param n_edges is the number of edges to draw
+ * @param seed    picks the stream
+ * return n_edges uniformly random edges over n_edges / 8 vertices
+ */
+std::vector<Graph::edge_descriptor> random_edges (std::size_t n_edges, unsigned seed) {
+    const int n_vertices = std::max<std::size_t>(n_edges / 8, 1);
+    std::mt19937 r(seed);
+    std::uniform_int_distribution<int> d(0, n_vertices - 1);
+    std::vector<Graph::edge_descriptor> x;
+    x.reserve(n_edges);
+    for (std::size_t i = 0; i != n_edges; ++i)
+        x.push_back(std::make_pair(d(r), d(r)));
+    return x;}
+
+// ----------
+// bench_edge
+// ----------
+
+/**
+ * build a Graph from n_edges random edges, then time edge() hits and misses
+ * against a linear scan of edges(), which is what edge() used to cost
+ */
+void bench_edge (std::size_t n_edges) {
+    const std::vector<Graph::edge_descriptor> x = random_edges(n_edges, 1);
+    const std::vector<Graph::edge_descriptor> y = random_edges(n_edges, 2);
+
+    Graph g;
+    clock_type::time_point t0 = clock_type::now();
+    for (std::size_t i = 0; i != x.size(); ++i)
+        add_edge(x[i].first, x[i].second, g);
+    clock_type::time_point t1 = clock_type::now();
+
+    std::size_t found = 0;
+    for (std::size_t i = 0; i != x.size(); ++i)
+        found += edge(x[i].first, x[i].second, g).second;
+    for (std::size_t i = 0; i != y.size(); ++i)
+        found += edge(y[i].first, y[i].second, g).second;
+    clock_type::time_point t2 = clock_type::now();
+
+    const std::size_t n_scans = std::min<std::size_t>(y.size(), 4);
+    std::pair<Graph::edge_iterator, Graph::edge_iterator> p = edges(g);
+    for (std::size_t i = 0; i != n_scans; ++i)
+        found += std::find(p.first, p.second, y[i]) != p.second;
+    clock_type::time_point t3 = clock_type::now();
+
+    const double add  = seconds(t0, t1) / x.size()               * 1e9;
+    const double look = seconds(t1, t2) / (x.size() + y.size())  * 1e9;
+    const double scan = seconds(t2, t3) / n_scans                * 1e9;
+    std::cout << "edges "          << num_edges(g)
+              << "  add_edge "     << add  << " ns"
+              << "  edge "         << look << " ns"
+              << "  linear scan "  << scan << " ns"
+              << "  speedup "      << (scan / look)
+              << "  (" << found << " found)" << std::endl;}
+
+// ---------------
+// bench_add_edges
+// ---------------
+
+/**
+ * load n_edges random edges with add_edges, serially and on every core
+ */
+void bench_add_edges (std::size_t n_edges) {
+    const std::vector<Graph::edge_descriptor> x = random_edges(n_edges, 1);
+
+    Graph g1;
+    clock_type::time_point t0 = clock_type::now();
+    add_edges(x.begin(), x.end(), g1, 1);
+    clock_type::time_point t1 = clock_type::now();
+
+    Graph gn;
+    add_edges(x.begin(), x.end(), gn);
+    clock_type::time_point t2 = clock_type::now();
+
+    std::cout << "edges "                << num_edges(g1)
+              << "  add_edges serial "   << (seconds(t0, t1) / x.size() * 1e9) << " ns"
+              << "  add_edges parallel " << (seconds(t1, t2) / x.size() * 1e9) << " ns"
+              << std::endl;}
+
+// ---------------
+// bench_concurrent
+// ---------------
+
+/**
+ * insert n_edges random edges from n_threads threads, into a GraphConcurrent and into a Graph behind one mutex;
+ * the GraphConcurrent twice, once with no reader and once while one more thread takes snapshots and scans them
+ */
+void bench_concurrent (std::size_t n_edges, std::size_t n_threads) {
+    const std::vector<Graph::edge_descriptor> x = random_edges(n_edges, 1);
+
+    clock_type::time_point t0 = clock_type::now();
+    {
+    GraphConcurrent g;
+    parallel_for(x.size(), n_threads, [&] (std::size_t, std::size_t i, std::size_t j) {
+        for (; i != j; ++i)
+            add_edge(x[i].first, x[i].second, g);});
+    }
+    clock_type::time_point t1 = clock_type::now();
+
+    GraphConcurrent   g;
+    std::atomic<bool> writing(true);
+    std::size_t       n_snapshots = 0;
+    std::thread       reader([&] () {
+        while (writing.load()) {
+            GraphSnapshot s(g);
+            n_snapshots += num_edges(s) != 0;}});
+    clock_type::time_point t2 = clock_type::now();
+    parallel_for(x.size(), n_threads, [&] (std::size_t, std::size_t i, std::size_t j) {
+        for (; i != j; ++i)
+            add_edge(x[i].first, x[i].second, g);});
+    clock_type::time_point t3 = clock_type::now();
+    writing = false;
+    reader.join();
+
+    Graph      h;
+    std::mutex m;
+    clock_type::time_point t4 = clock_type::now();
+    parallel_for(x.size(), n_threads, [&] (std::size_t, std::size_t i, std::size_t j) {
+        for (; i != j; ++i) {
+            std::lock_guard<std::mutex> l(m);
+            add_edge(x[i].first, x[i].second, h);}});
+    clock_type::time_point t5 = clock_type::now();
+
+    std::cout << "edges "                               << num_edges(g)
+              << "  threads "                           << n_threads
+              << "  GraphConcurrent add_edge "          << (seconds(t0, t1) / x.size() * 1e9) << " ns"
+              << "  with a snapshot reader "            << (seconds(t2, t3) / x.size() * 1e9) << " ns"
+              << "  Graph with mutex add_edge "         << (seconds(t4, t5) / x.size() * 1e9) << " ns"
+              << "  snapshots "                         << n_snapshots
+              << std::endl;}
+
+// ----------
+// generators
+// ----------
+
+typedef std::vector<Graph::edge_descriptor> edge_list;
+
+/**
+ * @param scale is log2 of the number of vertices
+ * R-MAT with the Graph500 probabilities a = 0.57, b = 0.19, c = 0.19: a skewed, power-law graph
+ */
+edge_list rmat (int scale, unsigned seed) {
+    const std::size_t m = std::size_t(16) << scale;
+    std::mt19937 r(seed);
+    std::uniform_real_distribution<double> d(0, 1);
+    edge_list x;
+    x.reserve(m);
+    for (std::size_t i = 0; i != m; ++i) {
+        int u = 0;
+        int v = 0;
+        for (int b = 0; b != scale; ++b) {
+            const double p = d(r);
+            u = (u << 1) | (p >= 0.76);
+            v = (v << 1) | (((p >= 0.57) && (p < 0.76)) || (p >= 0.95));}
+        x.push_back(std::make_pair(u, v));}
+    return x;}
+
+/**
+ * @param scale is log2 of the number of vertices
+ * Erdos-Renyi: every edge uniformly at random
+ */
+edge_list erdos_renyi (int scale, unsigned seed) {
+    const std::size_t m = std::size_t(16) << scale;
+    std::mt19937 r(seed);
+    std::uniform_int_distribution<int> d(0, (1 << scale) - 1);
+    edge_list x;
+    x.reserve(m);
+    for (std::size_t i = 0; i != m; ++i)
+        x.push_back(std::make_pair(d(r), d(r)));
+    return x;}
+
+/**
+ * a 2^(scale / 2) by 2^(scale - scale / 2) grid, so 2^scale vertices; each vertex has edges to the
+ * vertices up to 3 rows below and 2 columns either side, and to the next one right, so 16 edges per
+ * vertex away from the border
+ */
+edge_list grid (int scale, unsigned) {
+    const int rows = 1 << (scale / 2);
+    const int cols = 1 << (scale - (scale / 2));
+    edge_list x;
+    for (int i = 0; i != rows; ++i)
+        for (int j = 0; j != cols; ++j) {
+            const int v = (i * cols) + j;
+            if (j + 1 != cols)
+                x.push_back(std::make_pair(v, v + 1));
+            for (int di = 1; (di <= 3) && (i + di < rows); ++di)
+                for (int dj = -2; dj <= 2; ++dj)
+                    if ((j + dj >= 0) && (j + dj < cols))
+                        x.push_back(std::make_pair(v, v + (di * cols) + dj));}
+    return x;}
+
+// ---------------
+// bench_intersect
+// ---------------
+
+/**
+ * intersect pairs of random sorted lists of about n elements with std::set_intersection, with each kernel,
+ * and with intersect, which picks one; the pairs are drawn from enough lists, up to a million elements in all,
+ * that the branch predictor cannot learn them
+ */
+void bench_intersect (std::size_t n) {
+    typedef std::size_t (*kernel_type) (const int*, std::size_t, const int*, std::size_t, int*);
+    std::mt19937                       r(1);
+    std::uniform_int_distribution<int> d(0, 4 * n);
+    std::vector<std::vector<int> >     x(std::min<std::size_t>(4096, std::max<std::size_t>(64, (1 << 20) / n)));
+    for (std::size_t i = 0; i != x.size(); ++i) {
+        for (std::size_t j = 0; j != n; ++j)
+            x[i].push_back(d(r));
+        std::sort(x[i].begin(), x[i].end());
+        x[i].erase(std::unique(x[i].begin(), x[i].end()), x[i].end());}
+    const std::size_t n_pairs = std::max<std::size_t>(1, (1 << 24) / n);
+    std::vector<std::pair<std::size_t, std::size_t> > pairs(n_pairs);
+    std::uniform_int_distribution<std::size_t> e(0, x.size() - 1);
+    for (std::size_t i = 0; i != n_pairs; ++i)
+        pairs[i] = std::make_pair(e(r), e(r));
+
+    std::vector<int>       y(n);
+    std::size_t            sum = 0;
+    clock_type::time_point t0  = clock_type::now();
+    for (std::size_t i = 0; i != n_pairs; ++i) {
+        const std::vector<int>& a = x[pairs[i].first];
+        const std::vector<int>& b = x[pairs[i].second];
+        sum += std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), y.begin()) - y.begin();}
+    std::cout << "list " << n << "  std::set_intersection " << (seconds(t0, clock_type::now()) / n_pairs * 1e9) << " ns";
+
+    std::vector<const char*> names;
+    std::vector<kernel_type> kernels;
+    names.push_back("scalar");
+    kernels.push_back(intersect_scalar<int>);
+    #ifdef GRAPH_SIMD
+    names.push_back("sse");
+    kernels.push_back(intersect_sse<int>);
+    if (has_avx2()) {
+        names.push_back("avx2");
+        kernels.push_back(intersect_avx2<int>);}
+    #endif
+    names.push_back("intersect");
+    kernels.push_back(intersect<int>);
+    for (std::size_t k = 0; k != kernels.size(); ++k) {
+        clock_type::time_point t1 = clock_type::now();
+        for (std::size_t i = 0; i != n_pairs; ++i) {
+            const std::vector<int>& a = x[pairs[i].first];
+            const std::vector<int>& b = x[pairs[i].second];
+            sum += kernels[k](a.data(), a.size(), b.data(), b.size(), y.data());}
+        std::cout << "  " << names[k] << " " << (seconds(t1, clock_type::now()) / n_pairs * 1e9) << " ns";}
+    std::cout << "  checksum " << sum << std::endl;}
+
+// ---------------
+// bench_triangles
+// ---------------
+
+/**
+ * count the triangles of an R-MAT graph, and the Jaccard similarity of the ends of every edge
+ */
+void bench_triangles (int scale) {
+    const edge_list x = rmat(scale, 1);
+    Graph g;
+    add_edges(x.begin(), x.end(), g);
+    clock_type::time_point t0 = clock_type::now();
+    const uint64_t t = triangle_count(g);
+    clock_type::time_point t1 = clock_type::now();
+    std::vector<double> j;
+    edge_jaccard(g, j);
+    clock_type::time_point t2 = clock_type::now();
+    std::cout << "rmat " << scale << "  edges " << num_edges(g) << "  triangles " << t
+              << "  triangle_count " << seconds(t0, t1) << " s"
+              << "  edge_jaccard "   << seconds(t1, t2) << " s" << std::endl;}
+
+// -----
+// names
+// -----
+
+const char* name (const Graph*) {
+    return "Graph";}
+
+const char* name (const BasicGraph<uint32_t>*) {
+    return "BasicGraph<uint32_t>";}
+
+const char* name (const boost::adjacency_list<boost::setS, boost::vecS, boost::directedS>*) {
+    return "boost::adjacency_list<setS, vecS, directedS>";}
+
+// ----------
+// peak_rss_kb
+// ----------
+
+long peak_rss_kb () {
+    rusage u;
+    getrusage(RUSAGE_SELF, &u);
+    return u.ru_maxrss;}
+
+// ----
+// json
+// ----
+
+/**
+ * return x as a JSON number, or null when it is not finite, as a rate over a timing of 0 is not
+ */
+std::string json (double x) {
+    if (!std::isfinite(x))
+        return "null";
+    std::ostringstream out;
+    out << x;
+    return out.str();}
+
+// ----------
+// bench_case
+// ----------
+
+/**
+ * build a G from x with add_edge, then time edge() on hits and misses, a pass over edges(),
+ * a pass over every adjacent_vertices, a copy, and the copy's teardown; print the results as one JSON object
+ */
+template <typename G>
+void bench_case (const char* generator, int scale, const edge_list& x) {
+    typedef typename G::vertex_iterator    vertex_iterator;
+    typedef typename G::edge_iterator      edge_iterator;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+
+    const long rss = peak_rss_kb();
+    std::size_t sum = 0;
+
+    G g;
+    clock_type::time_point t0 = clock_type::now();
+    for (std::size_t i = 0; i != x.size(); ++i)
+        add_edge(x[i].first, x[i].second, g);
+    clock_type::time_point t1 = clock_type::now();
+
+    const std::size_t n_lookups = std::min<std::size_t>(x.size(), 1 << 20);
+    const int         n         = num_vertices(g);
+    for (std::size_t i = 0; i != n_lookups; ++i)
+        sum += edge(x[i].first, x[i].second, g).second + edge(x[i].second, (x[i].first + 1) % n, g).second;
+    clock_type::time_point t2 = clock_type::now();
+
+    std::pair<edge_iterator, edge_iterator> p = edges(g);
+    for (; p.first != p.second; ++p.first)
+        sum += source(*p.first, g) ^ target(*p.first, g);
+    clock_type::time_point t3 = clock_type::now();
+
+    std::pair<vertex_iterator, vertex_iterator> q = vertices(g);
+    for (; q.first != q.second; ++q.first) {
+        std::pair<adjacency_iterator, adjacency_iterator> r = adjacent_vertices(*q.first, g);
+        for (; r.first != r.second; ++r.first)
+            sum += *r.first;}
+    clock_type::time_point t4 = clock_type::now();
+
+    const long rss_built = peak_rss_kb();
+    clock_type::time_point t5 = clock_type::now();
+    G* h = new G(g);
+    sum += num_edges(*h);
+    clock_type::time_point t6 = clock_type::now();
+    delete h;
+    clock_type::time_point t7 = clock_type::now();
+
+    const double m = num_edges(g);
+    std::cout << "{\"type\": \""                  << name(&g)                       << "\""
+              << ", \"generator\": \""            << generator                      << "\""
+              << ", \"scale\": "                  << scale
+              << ", \"vertices\": "               << num_vertices(g)
+              << ", \"edges\": "                  << num_edges(g)
+              << ", \"add_edge_per_second\": "    << json(x.size() / seconds(t0, t1))
+              << ", \"edge_lookup_ns\": "         << json(seconds(t1, t2) / (2 * n_lookups) * 1e9)
+              << ", \"edges_scan_ns_per_edge\": " << json(seconds(t2, t3) / m * 1e9)
+              << ", \"adjacency_scan_ns_per_edge\": " << json(seconds(t3, t4) / m * 1e9)
+              << ", \"copy_seconds\": "           << json(seconds(t5, t6))
+              << ", \"teardown_seconds\": "       << json(seconds(t6, t7))
+              << ", \"rss_before_kb\": "          << rss
+              << ", \"rss_built_kb\": "           << rss_built
+              << ", \"peak_rss_kb\": "            << peak_rss_kb()
+              << ", \"checksum\": "               << sum
+              << "}" << std::flush;}
+
+// -----------
+// bench_suite
+// -----------
+
+/**
+ * run every graph type on every generator at every scale, each in a child process,
+ * and print a JSON array with one object per case
+ */
+void bench_suite (const std::vector<int>& scales) {
+    typedef boost::adjacency_list<boost::setS, boost::vecS, boost::directedS> boost_graph;
+    typedef edge_list (*generator_type) (int, unsigned);
+
+    const char*          names[]      = {"rmat", "erdos_renyi", "grid"};
+    const generator_type generators[] = {rmat, erdos_renyi, grid};
+    const char*          types[]      = {name(static_cast<Graph*>(0)), name(static_cast<BasicGraph<uint32_t>*>(0)), name(static_cast<boost_graph*>(0))};
+
+    bool first = true;
+    std::cout << "[";
+    for (std::size_t i = 0; i != scales.size(); ++i)
+        for (int j = 0; j != 3; ++j)
+            for (int k = 0; k != 3; ++k) {
+                std::cout << (first ? "\n" : ",\n") << std::flush;
+                first = false;
+                const pid_t pid = fork();
+                if (pid == 0) {
+                    const edge_list x = generators[j](scales[i], 1);
+                    if (k == 0)
+                        bench_case<Graph>(names[j], scales[i], x);
+                    else if (k == 1)
+                        bench_case<BasicGraph<uint32_t> >(names[j], scales[i], x);
+                    else
+                        bench_case<boost_graph>(names[j], scales[i], x);
+                    _exit(0);}
+                int status = 0;
+                waitpid(pid, &status, 0);
+                if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+                    std::cout << "{\"error\": \"case failed\", \"type\": \"" << types[k] << "\", \"generator\": \"" << names[j] << "\", \"scale\": " << scales[i] << "}";}
+    std::cout << "\n]" << std::endl;}
+
+// -----
+// usage
+// -----
+
+/**
+ * print the modes to cerr
+ * return the exit status for a bad command line
+ */
+int usage (const char* program) {
+    std::cerr << "usage: " << program << " suite      [scale ...]"  << std::endl
+              << "       " << program << " lookup     [edges ...]"  << std::endl
+              << "       " << program << " concurrent [threads ...]" << std::endl
+              << "       " << program << " intersect  [size ...]"   << std::endl;
+    return 2;}
+
+// ----
+// main
+// ----
+
+int main (int argc, char* argv[]) {
+    using namespace std;
+    if ((argc < 2) || ((strcmp(argv[1], "suite")      != 0) && (strcmp(argv[1], "lookup")    != 0) &&
+                       (strcmp(argv[1], "concurrent") != 0) && (strcmp(argv[1], "intersect") != 0)))
+        return usage(argv[0]);
+
+    if ((argc > 1) && (strcmp(argv[1], "lookup") == 0)) {
+        vector<size_t> sizes;
+        for (int i = 2; i < argc; ++i)
+            sizes.push_back(atol(argv[i]));
+        if (sizes.empty()) {
+            sizes.push_back(10000);
+            sizes.push_back(1000000);
+            sizes.push_back(10000000);}
+
+        cout << "BenchGraph.c++" << endl;
+        for (size_t i = 0; i != sizes.size(); ++i)
+            bench_edge(sizes[i]);
+        for (size_t i = 0; i != sizes.size(); ++i)
+            bench_add_edges(sizes[i]);
+        cout << "Done." << endl;
+        return 0;}
+
+    if ((argc > 1) && (strcmp(argv[1], "intersect") == 0)) {
+        vector<size_t> sizes;
+        for (int i = 2; i < argc; ++i)
+            sizes.push_back(atol(argv[i]));
+        if (sizes.empty()) {
+            sizes.push_back(16);
+            sizes.push_back(256);
+            sizes.push_back(4096);}
+
+        for (size_t i = 0; i != sizes.size(); ++i)
+            bench_intersect(sizes[i]);
+        bench_triangles(16);
+        return 0;}
+
+    if ((argc > 1) && (strcmp(argv[1], "concurrent") == 0)) {
+        vector<size_t> threads;
+        for (int i = 2; i < argc; ++i)
+            threads.push_back(atol(argv[i]));
+        if (threads.empty()) {
+            threads.push_back(1);
+            threads.push_back(2);
+            threads.push_back(4);
+            threads.push_back(8);}
+
+        for (size_t i = 0; i != threads.size(); ++i)
+            bench_concurrent(1000000, threads[i]);
+        return 0;}
+
+    vector<int> scales;
+    for (int i = 2; i < argc; ++i)
+        scales.push_back(atoi(argv[i]));
+    if (scales.empty()) {
+        scales.push_back(10);
+        scales.push_back(13);
+        scales.push_back(16);}
+    bench_suite(scales);
+    return 0;}
@@ -15,33 +15,467 @@
 #include <cstddef> // size_t
 #include <utility> // make_pair, pair
 #include <vector>  // vector
-#include <set>     // set
 #include <algorithm> // std::sort
 #include <iostream>
+#include <iterator>  // bidirectional_iterator_tag, forward_iterator_tag
+#include <limits>    // numeric_limits
+#include <memory>    // allocator, allocator_traits
+#include <type_traits> // is_same, true_type
+#include <thread>    // thread
+#include <stdint.h>  // uint64_t
+#include <cstdio>    // remove, rename
+#include <cstring>   // memcmp, memcpy
+#include <fstream>   // ofstream
+#include <string>    // string
+#include <atomic>             // atomic
+#include <chrono>             // steady_clock
+#include <condition_variable> // condition_variable
+#include <deque>              // deque
+#include <mutex>              // mutex, unique_lock
+
+#include <fcntl.h>    // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // close, getpid
+
+// sorted-list intersection uses SSE2, which every x86-64 has, and AVX2 when the running CPU has it;
+// define GRAPH_NO_SIMD to build only the scalar kernels
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(GRAPH_NO_SIMD)
+#define GRAPH_SIMD
+#include <immintrin.h> // _mm_cmpeq_epi32, _mm256_cmpeq_epi32
+#endif
 
 
 using namespace std;
 
-// -----
-// Graph
-// -----
+// ---------------
+// default_threads
+// ---------------
+
+/**
+ * @param n_threads is the requested number of threads, 0 for one per core
+ * @param n_items   is the amount of work to split
+ * @param grain     is the fewest items worth giving a thread
+ * return the number of threads to use, at least 1
+ */
+inline std::size_t default_threads (std::size_t n_threads, std::size_t n_items, std::size_t grain) {
+    if (n_threads == 0)
+        n_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    return std::max<std::size_t>(std::min(n_threads, n_items / grain), 1);}
+
+// ------------
+// parallel_for
+// ------------
+
+/**
+ * @param n         is the number of items
+ * @param n_threads is the number of threads, run inline when 1
+ * @param f         is called as f(t, b, e) for thread t over the items [b, e)
+ */
+template <typename F>
+void parallel_for (std::size_t n, std::size_t n_threads, F f) {
+    if (n_threads <= 1) {
+        f(0, 0, n);
+        return;}
+    std::vector<std::thread> x;
+    x.reserve(n_threads);
+    for (std::size_t t = 0; t != n_threads; ++t)
+        x.push_back(std::thread(f, t, n * t / n_threads, n * (t + 1) / n_threads));
+    for (std::size_t t = 0; t != n_threads; ++t)
+        x[t].join();}
+
+// ---------------
+// parallel_chunks
+// ---------------
+
+/**
+ * @param n         is the number of items
+ * @param n_threads is the number of threads, run inline when 1
+ * @param grain     is the number of items a thread takes at a time
+ * @param f         is called as f(t, b, e) for thread t over each chunk [b, e) that it takes
+ * threads take chunks from a shared counter until none are left, which balances skewed work
+ */
+template <typename F>
+void parallel_chunks (std::size_t n, std::size_t n_threads, std::size_t grain, F f) {
+    grain     = std::max<std::size_t>(grain, 1);
+    n_threads = std::max<std::size_t>(std::min(n_threads, (n + grain - 1) / grain), 1);
+    if (n_threads == 1) {
+        f(0, 0, n);
+        return;}
+    std::atomic<std::size_t> next(0);
+    parallel_for(n_threads, n_threads, [&] (std::size_t t, std::size_t, std::size_t) {
+        for (std::size_t b = next.fetch_add(grain); b < n; b = next.fetch_add(grain))
+            f(t, b, std::min(n, b + grain));});}
+
+// ----------
+// radix_sort
+// ----------
+
+/**
+ * @param a         is the keys to sort in place
+ * @param n_threads is the number of threads
+ * stable LSD radix sort, one byte per pass; passes where every key shares the byte are skipped
+ */
+inline void radix_sort (std::vector<uint64_t>& a, std::size_t n_threads) {
+    const std::size_t n = a.size();
+    std::vector<uint64_t> b(n);
+    std::vector< std::vector<std::size_t> > h(n_threads, std::vector<std::size_t>(256));
+    for (int shift = 0; shift != 64; shift += 8) {
+        parallel_for(n, n_threads, [&] (std::size_t t, std::size_t i, std::size_t j) {
+            std::fill(h[t].begin(), h[t].end(), 0);
+            for (; i != j; ++i)
+                ++h[t][(a[i] >> shift) & 0xFF];});
+        bool      skip = false;
+        std::size_t  s = 0;
+        for (int d = 0; d != 256; ++d) {
+            std::size_t c = 0;
+            for (std::size_t t = 0; t != n_threads; ++t) {
+                const std::size_t k = h[t][d];
+                h[t][d] = s + c;
+                c += k;}
+            skip = skip || (c == n);
+            s += c;}
+        if (skip)
+            continue;
+        parallel_for(n, n_threads, [&] (std::size_t t, std::size_t i, std::size_t j) {
+            for (; i != j; ++i)
+                b[h[t][(a[i] >> shift) & 0xFF]++] = a[i];});
+        a.swap(b);}}
+
+// -------------------
+// GraphVertexIterator
+// -------------------
+
+/**
+ * counts through the vertex_descriptors 0 to num_vertices - 1
+ * the count is held in a std::size_t, so the end of a graph that uses the largest V does not wrap to 0
+ */
+template <typename V>
+class GraphVertexIterator {
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef V                               value_type;
+        typedef std::ptrdiff_t                  difference_type;
+        typedef const V*                        pointer;
+        typedef V                               reference;
+
+    private:
+        std::size_t _v;
+
+    public:
+        GraphVertexIterator () :
+                _v (0)
+            {}
+
+        explicit GraphVertexIterator (std::size_t v) :
+                _v (v)
+            {}
+
+        friend bool operator == (const GraphVertexIterator& lhs, const GraphVertexIterator& rhs) {
+            return lhs._v == rhs._v;}
+
+        friend bool operator != (const GraphVertexIterator& lhs, const GraphVertexIterator& rhs) {
+            return !(lhs == rhs);}
+
+        reference operator * () const {
+            return static_cast<V>(_v);}
+
+        GraphVertexIterator& operator ++ () {
+            ++_v;
+            return *this;}
+
+        GraphVertexIterator operator ++ (int) {
+            GraphVertexIterator x = *this;
+            ++*this;
+            return x;}
+
+        GraphVertexIterator& operator -- () {
+            --_v;
+            return *this;}
+
+        GraphVertexIterator operator -- (int) {
+            GraphVertexIterator x = *this;
+            --*this;
+            return x;}};
+
+// ----------
+// GraphArena
+// ----------
+
+/**
+ * monotonic arena: hands out memory from a few large blocks and frees it all at once when destroyed
+ * allocation is locked, so graphs grown from different threads can share an arena
+ * memory given back by a container is not reused until the arena goes away
+ */
+class GraphArena {
+    private:
+        std::vector<char*> _blocks;
+        char*              _p;
+        std::size_t        _left;
+        std::size_t        _next;
+        std::size_t        _reserved;
+        std::mutex         _m;
+
+        GraphArena             (const GraphArena&);
+        GraphArena& operator = (const GraphArena&);
+
+    public:
+        /**
+         * @param block_size is the size of the first block; each later block is twice the last
+         */
+        explicit GraphArena (std::size_t block_size = 1 << 16) :
+                _p        (0),
+                _left     (0),
+                _next     (std::max<std::size_t>(block_size, 64)),
+                _reserved (0)
+            {}
+
+        ~GraphArena () {
+            for (std::size_t i = 0; i != _blocks.size(); ++i)
+                ::operator delete(_blocks[i]);}
+
+        void* allocate (std::size_t n, std::size_t align) {
+            std::lock_guard<std::mutex> l(_m);
+            std::size_t pad = (align - (reinterpret_cast<uintptr_t>(_p) % align)) % align;
+            if ((pad + n) > _left) {
+                const std::size_t size = std::max(_next, n + align);
+                _blocks.push_back(static_cast<char*>(::operator new(size)));
+                _p         = _blocks.back();
+                _left      = size;
+                _next     *= 2;
+                _reserved += size;
+                pad        = (align - (reinterpret_cast<uintptr_t>(_p) % align)) % align;}
+            void* r = _p + pad;
+            _p    += pad + n;
+            _left -= pad + n;
+            return r;}
+
+        /**
+         * return the bytes taken from the system so far
+         */
+        std::size_t reserved () const {
+            return _reserved;}};
+
+// --------------
+// ArenaAllocator
+// --------------
+
+/**
+ * allocator over a GraphArena; deallocate does nothing, so tearing down a graph built on one costs
+ * one free per arena block instead of one per vertex
+ */
+template <typename T>
+class ArenaAllocator {
+    template <typename U>
+    friend class ArenaAllocator;
+
+    private:
+        GraphArena* _arena;
+
+    public:
+        typedef T              value_type;
+        typedef std::true_type propagate_on_container_copy_assignment;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        explicit ArenaAllocator (GraphArena& arena) :
+                _arena (&arena)
+            {}
+
+        template <typename U>
+        ArenaAllocator (const ArenaAllocator<U>& that) :
+                _arena (that._arena)
+            {}
+
+        T* allocate (std::size_t n) {
+            return static_cast<T*>(_arena->allocate(n * sizeof(T), alignof(T)));}
+
+        void deallocate (T*, std::size_t)
+            {}
+
+        friend bool operator == (const ArenaAllocator& lhs, const ArenaAllocator& rhs) {
+            return lhs._arena == rhs._arena;}
+
+        friend bool operator != (const ArenaAllocator& lhs, const ArenaAllocator& rhs) {
+            return !(lhs == rhs);}};
+
+// --------------
+// GraphAdjacency
+// --------------
+
+/**
+ * sorted adjacency list that holds up to inline_capacity targets in place, in the same 24 bytes as a
+ * std::vector, and only allocates for larger degrees
+ * the owning graph keeps the allocator and passes it to every call that can allocate or free
+ */
+template <typename T>
+class GraphAdjacency {
+    public:
+        static const uint32_t inline_capacity = (16 / sizeof(T)) ? (16 / sizeof(T)) : 1;
+
+    private:
+        uint32_t _size;
+        uint32_t _capacity;
+        union {
+            T* _p;
+            T  _b[inline_capacity];};
+
+        bool spilled () const {
+            return _capacity > inline_capacity;}
+
+    public:
+        GraphAdjacency () :
+                _size     (0),
+                _capacity (inline_capacity)
+            {}
+
+        const T* begin () const {
+            return spilled() ? _p : _b;}
+
+        T* begin () {
+            return spilled() ? _p : _b;}
+
+        const T* end () const {
+            return begin() + _size;}
+
+        T* end () {
+            return begin() + _size;}
 
-class Graph {
+        std::size_t size () const {
+            return _size;}
+
+        template <typename A>
+        void reserve (std::size_t n, A& a) {
+            if (n <= _capacity)
+                return;
+            const uint32_t c = std::max<std::size_t>(n, 2 * std::size_t(_capacity));
+            T* q = std::allocator_traits<A>::allocate(a, c);
+            std::memcpy(q, begin(), _size * sizeof(T));
+            release(a);
+            _p        = q;
+            _capacity = c;}
+
+        template <typename A>
+        void push_back (T x, A& a) {
+            reserve(_size + 1, a);
+            begin()[_size++] = x;}
+
+        template <typename A>
+        void insert (T* p, T x, A& a) {
+            const std::size_t i = p - begin();
+            reserve(_size + 1, a);
+            T* b = begin();
+            std::memmove(b + i + 1, b + i, (_size - i) * sizeof(T));
+            b[i] = x;
+            ++_size;}
+
+        template <typename A>
+        void assign (const GraphAdjacency& that, A& a) {
+            _size = 0;
+            reserve(that._size, a);
+            std::memcpy(begin(), that.begin(), that._size * sizeof(T));
+            _size = that._size;}
+
+        /**
+         * free any allocated storage; the list is left empty only if it was inline
+         */
+        template <typename A>
+        void release (A& a) {
+            if (spilled())
+                std::allocator_traits<A>::deallocate(a, _p, _capacity);
+            _capacity = inline_capacity;}};
+
+template <typename T>
+const uint32_t GraphAdjacency<T>::inline_capacity;
+
+// ----------
+// BasicGraph
+// ----------
+
+/**
+ * directed graph over the vertices 0 to num_vertices - 1
+ * V is the vertex index type, A the allocator for adjacency storage, such as ArenaAllocator<V>
+ * every vertex keeps a sorted GraphAdjacency; there are no per-edge nodes
+ */
+template <typename V = int, typename A = std::allocator<V> >
+class BasicGraph {
     public:
         // --------
         // typedefs
         // --------
 
-        typedef int vertex_descriptor;  
-        typedef std::pair<vertex_descriptor, vertex_descriptor> edge_descriptor;    
+        typedef V vertex_descriptor;
+        typedef std::pair<vertex_descriptor, vertex_descriptor> edge_descriptor;
 
-        typedef std::set<vertex_descriptor>::const_iterator vertex_iterator;    
-        typedef std::set<edge_descriptor>::const_iterator edge_iterator;      
-        typedef std::vector<vertex_descriptor>::const_iterator adjacency_iterator; 
+        typedef A                                 allocator_type;
+        typedef GraphAdjacency<vertex_descriptor> adjacency_type;
+
+        typedef GraphVertexIterator<vertex_descriptor> vertex_iterator;
+        typedef const vertex_descriptor*               adjacency_iterator;
 
         typedef std::size_t vertices_size_type;
         typedef std::size_t edges_size_type;
 
+        // -------------
+        // edge_iterator
+        // -------------
+
+        /**
+         * walks the adjacency lists in order, so edges come out ordered by (source, target)
+         */
+        class edge_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef edge_descriptor           value_type;
+                typedef std::ptrdiff_t            difference_type;
+                typedef const edge_descriptor*    pointer;
+                typedef edge_descriptor           reference;
+
+            private:
+                const adjacency_type* _a;
+                vertices_size_type    _n;
+                vertices_size_type    _u;
+                std::size_t           _i;
+
+                void skip () {
+                    while ((_u != _n) && (_i == _a[_u].size())) {
+                        ++_u;
+                        _i = 0;}}
+
+            public:
+                edge_iterator () :
+                        _a (0),
+                        _n (0),
+                        _u (0),
+                        _i (0)
+                    {}
+
+                edge_iterator (const adjacency_type* a, vertices_size_type n, vertices_size_type u) :
+                        _a (a),
+                        _n (n),
+                        _u (u),
+                        _i (0) {
+                    skip();}
+
+                friend bool operator == (const edge_iterator& lhs, const edge_iterator& rhs) {
+                    return (lhs._u == rhs._u) && (lhs._i == rhs._i);}
+
+                friend bool operator != (const edge_iterator& lhs, const edge_iterator& rhs) {
+                    return !(lhs == rhs);}
+
+                reference operator * () const {
+                    return std::make_pair(static_cast<vertex_descriptor>(_u), _a[_u].begin()[_i]);}
+
+                edge_iterator& operator ++ () {
+                    ++_i;
+                    skip();
+                    return *this;}
+
+                edge_iterator operator ++ (int) {
+                    edge_iterator x = *this;
+                    ++*this;
+                    return x;}};
+
     public:
         // --------
         // add_edge
@@ -52,39 +486,101 @@ class Graph {
          * @param v is a vertex_descriptor by value
          * @param g is a Graph by reference
          * return pair<edge_descriptor, bool> bool will be true if edge successfully added to graph g
+         * grows the vertex set to cover u and v; O(log deg(u)) lookup plus O(deg(u)) insertion
          */
-        friend std::pair<edge_descriptor, bool> add_edge (vertex_descriptor u, vertex_descriptor v, Graph& g) {
+        friend std::pair<edge_descriptor, bool> add_edge (vertex_descriptor u, vertex_descriptor v, BasicGraph& g) {
             // <your code>
             edge_descriptor ed = std::make_pair(u,v);
-            bool            b ;
-
-            vertex_descriptor max_size;
-            if(u > v)
-                max_size = u;
-            else 
-               max_size = v;
-
-            int v_size = g._v.size();
-
-            std::pair<std::set<edge_descriptor>::iterator , bool> pe = g._e.insert(ed);
-            bool temp = pe.second;
-            if(temp){
-                if(std::find(g._v.begin(), g._v.end(), max_size) == g._v.end()){
-                    for(int i = max_size; max_size != v_size-1 ; i--){
-                        add_vertex(g);
-                        max_size--;
-                    }    
-                }
-                b = true;
-                g._g[u].push_back(v);                
-            }   
-            else{
-                b = false;
-            }
-
-            sort(g._g[u].begin(), g._g[u].end());
-            
-            return std::make_pair(ed, b);}
+
+            vertex_descriptor max_size = std::max(u, v);
+            while (g._g.size() <= static_cast<vertices_size_type>(max_size))
+                add_vertex(g);
+
+            // _g[u] is kept sorted, so the duplicate check and the insertion point
+            // come from one binary search instead of a scan and a re-sort
+            adjacency_type&    a = g._g[u];
+            vertex_descriptor* p = std::lower_bound(a.begin(), a.end(), v);
+            if ((p != a.end()) && (*p == v))
+                return std::make_pair(ed, false);
+
+            a.insert(p, v, g._a);
+            ++g._m;
+            return std::make_pair(ed, true);}
+
+        // ---------
+        // add_edges
+        // ---------
+
+        /**
+         * @param b         is an input iterator to the first edge_descriptor
+         * @param e         is an input iterator past the last edge_descriptor
+         * @param g         is a Graph by reference
+         * @param n_threads is the number of threads, 0 for one per core, 1 for a serial build
+         * add every edge in [b, e) to g, ignoring duplicates and edges already in g
+         * the batch is sorted (radix sorted when both ends pack into 64 bits) and deduplicated,
+         * then each adjacency list is grown once
+         * the threads only find and merge the new edges; every list is grown from the calling thread in between,
+         * so A need not be safe to call from several threads
+         * return the number of edges added
+         */
+        template <typename II>
+        friend edges_size_type add_edges (II b, II e, BasicGraph& g, std::size_t n_threads = 0) {
+            std::vector<edge_descriptor> a(b, e);
+            if (a.empty())
+                return 0;
+            vertices_size_type n_vertices = 0;
+            for (std::size_t i = 0; i != a.size(); ++i) {
+                assert((a[i].first >= 0) && (a[i].second >= 0));
+                n_vertices = std::max<vertices_size_type>(n_vertices, std::max(a[i].first, a[i].second) + vertices_size_type(1));}
+
+            sort_edges(a, default_threads(n_threads, a.size(), 1 << 16));
+            a.erase(std::unique(a.begin(), a.end()), a.end());
+
+            while (g._g.size() < n_vertices)
+                add_vertex(g);
+
+            // each thread owns the sources whose runs start in its share of a,
+            // and compacts the edges that are new to g to the front of that share
+            const std::size_t        n = default_threads(n_threads, a.size(), 1 << 12);
+            std::vector<std::size_t> first(n + 1, a.size());
+            std::vector<std::size_t> last(n, 0);
+            for (std::size_t t = 0; t != n; ++t) {
+                std::size_t i = a.size() * t / n;
+                while ((i != 0) && (i != a.size()) && (a[i - 1].first == a[i].first))
+                    ++i;
+                first[t] = i;}
+            parallel_for(n, n, [&] (std::size_t t, std::size_t, std::size_t) {
+                std::size_t k = first[t];
+                for (std::size_t i = first[t]; i != first[t + 1]; ++i) {
+                    const adjacency_type& x = g._g[a[i].first];
+                    if (!std::binary_search(x.begin(), x.end(), a[i].second))
+                        a[k++] = a[i];}
+                last[t] = k;});
+
+            // grow each list to its final size here, so that the allocator is only called from this thread
+            for (std::size_t t = 0; t != n; ++t)
+                for (std::size_t i = first[t]; i != last[t];) {
+                    const vertex_descriptor u = a[i].first;
+                    const std::size_t       m = i;
+                    for (; (i != last[t]) && (a[i].first == u); ++i)
+                        {}
+                    g._g[u].reserve(g._g[u].size() + (i - m), g._a);}
+
+            parallel_for(n, n, [&] (std::size_t t, std::size_t, std::size_t) {
+                for (std::size_t i = first[t]; i != last[t];) {
+                    const vertex_descriptor u = a[i].first;
+                    adjacency_type&         x = g._g[u];
+                    const std::size_t       old_size = x.size();
+                    for (; (i != last[t]) && (a[i].first == u); ++i)
+                        x.push_back(a[i].second, g._a);
+                    std::inplace_merge(x.begin(), x.begin() + old_size, x.end());}});
+
+            edges_size_type s = 0;
+            for (std::size_t t = 0; t != n; ++t)
+                s += last[t] - first[t];
+            g._m += s;
+            assert(g.valid());
+            return s;}
 
         // ----------
         // add_vertex
@@ -95,11 +591,10 @@ class Graph {
          * add vertex to vertex vector and g
          * Return added vertex value
          */
-        friend vertex_descriptor add_vertex (Graph& g) {
+        friend vertex_descriptor add_vertex (BasicGraph& g) {
             // <your code>
-            vertex_descriptor v = g._g.size();     
-            g._v.insert(v);
-            g._g.push_back(std::vector<vertex_descriptor>());
+            vertex_descriptor v = g._g.size();
+            g._g.push_back(adjacency_type());
             return v;}
 
         // -----------------
@@ -112,10 +607,8 @@ class Graph {
          * iterate over all adjacent vertices
          * return a pair of iterators that point to the beginning and end of vertices adjacent to the specified vertex in g
          */
-        friend std::pair<adjacency_iterator, adjacency_iterator> adjacent_vertices (vertex_descriptor v, const Graph& g) {
+        friend std::pair<adjacency_iterator, adjacency_iterator> adjacent_vertices (vertex_descriptor v, const BasicGraph& g) {
             // <your code>
-            // static int a [] = {0, 0};     // dummy data
-
             adjacency_iterator b = g._g[v].begin();
             adjacency_iterator e = g._g[v].end();
             return std::make_pair(b, e);}
@@ -129,19 +622,16 @@ class Graph {
          * @param v is a vertex_descriptor by value
          * @param g is a Graph by reference
          * return pair<edge_descriptor, bool> bool will be true if edge in g
+         * binary search over the sorted adjacency of u, O(log deg(u))
          */
-        friend std::pair<edge_descriptor, bool> edge (vertex_descriptor u, vertex_descriptor v, const Graph& g) {
+        friend std::pair<edge_descriptor, bool> edge (vertex_descriptor u, vertex_descriptor v, const BasicGraph& g) {
             // <your code>
             edge_descriptor ed = std::make_pair(u,v);
-            bool            b;
-            if(std::find(g._e.begin(), g._e.end(), ed) == g._e.end()){
-                b = false;
-            }
-            else{
-                b = true;
-            }
+            bool            b  = false;
+            if ((u >= 0) && (static_cast<vertices_size_type>(u) < g._g.size()))
+                b = std::binary_search(g._g[u].begin(), g._g[u].end(), v);
             return std::make_pair(ed, b);}
-     
+
         // -----
         // edges
         // -----
@@ -150,11 +640,10 @@ class Graph {
          * @param g is a Graph by reference
          * return pair of being and end iterators over edges in g
          */
-        friend std::pair<edge_iterator, edge_iterator> edges (const Graph& g) {
+        friend std::pair<edge_iterator, edge_iterator> edges (const BasicGraph& g) {
             // <your code>
-            // static int a [] = {0, 0};     // dummy data
-            edge_iterator b = g._e.begin();
-            edge_iterator e = g._e.end();
+            edge_iterator b(g._g.data(), g._g.size(), 0);
+            edge_iterator e(g._g.data(), g._g.size(), g._g.size());
             return std::make_pair(b, e);}
 
         // ---------
@@ -165,11 +654,9 @@ class Graph {
          * @param g is a Graph by reference
          * return number of edges in g
          */
-        friend edges_size_type num_edges (const Graph& g) {
+        friend edges_size_type num_edges (const BasicGraph& g) {
             // <your code>
-            // edges_size_type s = 1; // fix
-
-            return g._e.size();}
+            return g._m;}
 
         // ------------
         // num_vertices
@@ -179,11 +666,9 @@ class Graph {
          * @param g is a Graph by reference
          * return number of verices in g
          */
-        friend vertices_size_type num_vertices (const Graph& g) {
+        friend vertices_size_type num_vertices (const BasicGraph& g) {
             // <your code>
-            // vertices_size_type s = 1; // fix
-
-            return g._v.size();}
+            return g._g.size();}
 
         // ------
         // source
@@ -194,9 +679,8 @@ class Graph {
          * @param g is a graph be reference
          * return vertex_descriptor of source
          */
-        friend vertex_descriptor source (edge_descriptor ed, const Graph& g) {
+        friend vertex_descriptor source (edge_descriptor ed, const BasicGraph&) {
             // <your code>
-            // vertex_descriptor v = 0; // fix
             return ed.first;}
 
         // ------
@@ -208,9 +692,8 @@ class Graph {
          * @param g is a graph be reference
          * return vertex_descriptor of target
          */
-        friend vertex_descriptor target (edge_descriptor ed, const Graph& g) {
+        friend vertex_descriptor target (edge_descriptor ed, const BasicGraph&) {
             // <your code>
-            // vertex_descriptor v = 0; // fix
             return ed.second;}
 
         // ------
@@ -222,9 +705,8 @@ class Graph {
          * @param g is a graph by reference
          * return vertex_descriptor of vertex
          */
-        friend vertex_descriptor vertex (vertices_size_type vs, const Graph& g) {
+        friend vertex_descriptor vertex (vertices_size_type vs, const BasicGraph&) {
             // <your code>
-            // vertex_descriptor vd = 0; // fix
             return vs;}
 
         // --------
@@ -235,11 +717,10 @@ class Graph {
          * @param g is a graph by reference
          * return begin and end iterators over the vertices of g
          */
-        friend std::pair<vertex_iterator, vertex_iterator> vertices (const Graph& g) {
+        friend std::pair<vertex_iterator, vertex_iterator> vertices (const BasicGraph& g) {
             // <your code>
-            // static int a [] = {0, 0};     // dummy data
-            vertex_iterator b = g._v.begin();
-            vertex_iterator e = g._v.end();
+            vertex_iterator b(0);
+            vertex_iterator e(g._g.size());
             return std::make_pair(b,e);}
 
     private:
@@ -247,22 +728,50 @@ class Graph {
         // data
         // ----
 
-        std::vector< std::vector<vertex_descriptor> > _g; // g cotains set of adjacent vertices
-        std::set<vertex_descriptor> _v;
-        std::set<edge_descriptor> _e; 
+        typedef typename std::allocator_traits<A>::template rebind_alloc<adjacency_type> vertex_allocator_type;
+
+        A                                                  _a; // for the adjacency lists that outgrow their inline space
+        std::vector<adjacency_type, vertex_allocator_type> _g; // _g[u] is the sorted targets of u
+        edges_size_type                                    _m;
+
+        // ----------
+        // sort_edges
+        // ----------
+
+        /**
+         * sort and keep duplicates; radix sort the edges as 64-bit keys when the vertices fit in 32 bits
+         */
+        static void sort_edges (std::vector<edge_descriptor>& a, std::size_t n_threads) {
+            if (sizeof(vertex_descriptor) > sizeof(uint32_t)) {
+                std::sort(a.begin(), a.end());
+                return;}
+            std::vector<uint64_t> k(a.size());
+            parallel_for(a.size(), n_threads, [&] (std::size_t, std::size_t i, std::size_t j) {
+                for (; i != j; ++i)
+                    k[i] = (static_cast<uint64_t>(a[i].first) << 32) | static_cast<uint32_t>(a[i].second);});
+            radix_sort(k, n_threads);
+            parallel_for(a.size(), n_threads, [&] (std::size_t, std::size_t i, std::size_t j) {
+                for (; i != j; ++i)
+                    a[i] = std::make_pair(static_cast<vertex_descriptor>(k[i] >> 32), static_cast<vertex_descriptor>(k[i] & 0xFFFFFFFF));});}
 
         // -----
         // valid
         // -----
 
         /**
-         * check if all sizes are 0 at default
+         * every adjacency list is sorted, without duplicates, and within the vertex set
          */
         bool valid () const {
-            // <your code>
-            if(_g.size() == _v.size())
-                return true;
-            return false;}
+            edges_size_type m = 0;
+            for (std::size_t u = 0; u != _g.size(); ++u) {
+                const adjacency_type& x = _g[u];
+                m += x.size();
+                for (std::size_t i = 1; i < x.size(); ++i)
+                    if (!(x.begin()[i - 1] < x.begin()[i]))
+                        return false;
+                if ((x.size() != 0) && (static_cast<vertices_size_type>(x.end()[-1]) >= _g.size()))
+                    return false;}
+            return m == _m;}
 
     public:
         // ------------
@@ -270,20 +779,3107 @@ class Graph {
         // ------------
 
         /**
-         * <your documentation>
+         * @param a is the allocator for the adjacency lists and the vertex table
          */
-        Graph () 
-        { // <your code>
-            _g = std::vector< std::vector<vertex_descriptor> >();
-            _v = std::set<vertex_descriptor>();
-            _e = std::set<edge_descriptor>();
-            assert(valid());
-        }
+        explicit BasicGraph (const A& a = A()) :
+                _a (a),
+                _g (vertex_allocator_type(a)),
+                _m (0) {
+            assert(valid());}
 
-        // Default copy, destructor, and copy assignment
-        // Graph  (const Graph<T>&);
-        // ~Graph ();
-        // Graph& operator = (const Graph&);
+        BasicGraph (const BasicGraph& that) :
+                _a (std::allocator_traits<A>::select_on_container_copy_construction(that._a)),
+                _g (that._g.size(), adjacency_type(), vertex_allocator_type(_a)),
+                _m (that._m) {
+            for (std::size_t u = 0; u != _g.size(); ++u)
+                _g[u].assign(that._g[u], _a);}
+
+        BasicGraph (BasicGraph&& that) :
+                _a (std::move(that._a)),
+                _g (std::move(that._g)),
+                _m (that._m) {
+            that._g.clear();
+            that._m = 0;}
+
+        BasicGraph& operator = (BasicGraph that) {
+            std::swap(_a, that._a);
+            _g.swap(that._g);
+            std::swap(_m, that._m);
+            return *this;}
+
+        ~BasicGraph () {
+            for (std::size_t u = 0; u != _g.size(); ++u)
+                _g[u].release(_a);}
     };
 
+// -----
+// Graph
+// -----
+
+typedef BasicGraph<> Graph;
+
+// --------
+// GraphCSR
+// --------
+
+/**
+ * immutable compressed-sparse-row snapshot of a graph
+ * V is the vertex index type
+ * the adjacency of vertex v is _targets[_offsets[v]] through _targets[_offsets[v + 1]]
+ * exposes the same read-only free functions as Graph
+ */
+template <typename V = int>
+class BasicGraphCSR {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef V vertex_descriptor;
+        typedef std::pair<vertex_descriptor, vertex_descriptor> edge_descriptor;
+
+        typedef const vertex_descriptor* adjacency_iterator;
+
+        typedef std::size_t vertices_size_type;
+        typedef std::size_t edges_size_type;
+
+        typedef GraphVertexIterator<vertex_descriptor> vertex_iterator;
+
+        // -------------
+        // edge_iterator
+        // -------------
+
+        /**
+         * walks the targets linearly, advancing the source vertex at each offset boundary
+         * shared by every compressed-sparse-row view
+         */
+        class edge_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef edge_descriptor           value_type;
+                typedef std::ptrdiff_t            difference_type;
+                typedef const edge_descriptor*    pointer;
+                typedef edge_descriptor           reference;
+
+            private:
+                const edges_size_type*   _offsets;
+                const vertex_descriptor* _targets;
+                vertices_size_type       _n;
+                vertices_size_type       _u;
+                edges_size_type          _i;
+
+                void skip () {
+                    while ((_u < _n) && (_offsets[_u + 1] == _i))
+                        ++_u;}
+
+            public:
+                edge_iterator () :
+                        _offsets (0),
+                        _targets (0),
+                        _n       (0),
+                        _u       (0),
+                        _i       (0)
+                    {}
+
+                /**
+                 * @param offsets is the n + 1 offsets of a compressed-sparse-row graph
+                 * @param targets is its targets
+                 * @param n       is its number of vertices
+                 * @param u       is the source of the i-th target
+                 * @param i       is the index into targets
+                 */
+                edge_iterator (const edges_size_type* offsets, const vertex_descriptor* targets, vertices_size_type n, vertices_size_type u, edges_size_type i) :
+                        _offsets (offsets),
+                        _targets (targets),
+                        _n       (n),
+                        _u       (u),
+                        _i       (i) {
+                    skip();}
+
+                friend bool operator == (const edge_iterator& lhs, const edge_iterator& rhs) {
+                    return lhs._i == rhs._i;}
+
+                friend bool operator != (const edge_iterator& lhs, const edge_iterator& rhs) {
+                    return !(lhs == rhs);}
+
+                reference operator * () const {
+                    return std::make_pair(static_cast<vertex_descriptor>(_u), _targets[_i]);}
+
+                edge_iterator& operator ++ () {
+                    ++_i;
+                    skip();
+                    return *this;}
+
+                edge_iterator operator ++ (int) {
+                    edge_iterator x = *this;
+                    ++*this;
+                    return x;}};
+
+    public:
+        // -----------------
+        // adjacent_vertices
+        // -----------------
+
+        /**
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphCSR by reference
+         * return a pair of iterators over the contiguous, sorted targets of v in g
+         */
+        friend std::pair<adjacency_iterator, adjacency_iterator> adjacent_vertices (vertex_descriptor v, const BasicGraphCSR& g) {
+            adjacency_iterator b = g._targets.data() + g._offsets[v];
+            adjacency_iterator e = g._targets.data() + g._offsets[v + 1];
+            return std::make_pair(b, e);}
+
+        // ----
+        // edge
+        // ----
+
+        /**
+         * @param u is a vertex_descriptor by value
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphCSR by reference
+         * return pair<edge_descriptor, bool> bool will be true if edge in g
+         * binary search over the targets of u, O(log deg(u))
+         */
+        friend std::pair<edge_descriptor, bool> edge (vertex_descriptor u, vertex_descriptor v, const BasicGraphCSR& g) {
+            edge_descriptor ed = std::make_pair(u, v);
+            bool            b  = false;
+            if ((u >= 0) && (static_cast<vertices_size_type>(u) < num_vertices(g))) {
+                std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+                b = std::binary_search(p.first, p.second, v);}
+            return std::make_pair(ed, b);}
+
+        // -----
+        // edges
+        // -----
+
+        /**
+         * @param g is a GraphCSR by reference
+         * return pair of begin and end iterators over edges in g, ordered by (source, target)
+         */
+        friend std::pair<edge_iterator, edge_iterator> edges (const BasicGraphCSR& g) {
+            edge_iterator b(g._offsets.data(), g._targets.data(), g.num_sources(), 0, 0);
+            edge_iterator e(g._offsets.data(), g._targets.data(), g.num_sources(), g.num_sources(), g._targets.size());
+            return std::make_pair(b, e);}
+
+        // ---------
+        // num_edges
+        // ---------
+
+        /**
+         * @param g is a GraphCSR by reference
+         * return number of edges in g
+         */
+        friend edges_size_type num_edges (const BasicGraphCSR& g) {
+            return g._targets.size();}
+
+        // ------------
+        // num_vertices
+        // ------------
+
+        /**
+         * @param g is a GraphCSR by reference
+         * return number of vertices in g
+         */
+        friend vertices_size_type num_vertices (const BasicGraphCSR& g) {
+            return g._offsets.size() - 1;}
+
+        // ------
+        // source
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * @param g is a GraphCSR by reference
+         * return vertex_descriptor of source
+         */
+        friend vertex_descriptor source (edge_descriptor ed, const BasicGraphCSR&) {
+            return ed.first;}
+
+        // ------
+        // target
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * @param g is a GraphCSR by reference
+         * return vertex_descriptor of target
+         */
+        friend vertex_descriptor target (edge_descriptor ed, const BasicGraphCSR&) {
+            return ed.second;}
+
+        // ------
+        // vertex
+        // ------
+
+        /**
+         * @param vs is a vertices_size_type by value
+         * @param g is a GraphCSR by reference
+         * return vertex_descriptor of vertex
+         */
+        friend vertex_descriptor vertex (vertices_size_type vs, const BasicGraphCSR&) {
+            return vs;}
+
+        // --------
+        // vertices
+        // --------
+
+        /**
+         * @param g is a GraphCSR by reference
+         * return begin and end iterators over the vertices of g
+         */
+        friend std::pair<vertex_iterator, vertex_iterator> vertices (const BasicGraphCSR& g) {
+            vertex_iterator b(0);
+            vertex_iterator e(g.num_sources());
+            return std::make_pair(b, e);}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        std::vector<edges_size_type>   _offsets; // _offsets[v] is the index of the first target of v
+        std::vector<vertex_descriptor> _targets; // all adjacency lists, back to back
+
+        vertices_size_type num_sources () const {
+            return _offsets.size() - 1;}
+
+        // -----
+        // valid
+        // -----
+
+        /**
+         * offsets start at 0, never decrease, and end at the number of targets
+         */
+        bool valid () const {
+            if (_offsets.empty() || (_offsets.front() != 0) || (_offsets.back() != _targets.size()))
+                return false;
+            for (std::size_t i = 1; i != _offsets.size(); ++i)
+                if (_offsets[i - 1] > _offsets[i])
+                    return false;
+            return true;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * empty snapshot
+         */
+        BasicGraphCSR () :
+                _offsets (1, 0),
+                _targets ()
+            {
+            assert(valid());}
+
+        /**
+         * @param g is a graph by reference, with the same vertex_descriptor
+         * freeze g in a single pass over its adjacency lists
+         */
+        template <typename G>
+        explicit BasicGraphCSR (const G& g) :
+                _offsets (),
+                _targets () {
+            typedef typename G::adjacency_iterator adjacency_iterator;
+            static_assert(std::is_same<typename G::vertex_descriptor, vertex_descriptor>::value, "g has another vertex_descriptor");
+            const vertices_size_type n = num_vertices(g);
+            _offsets.reserve(n + 1);
+            _targets.reserve(num_edges(g));
+            _offsets.push_back(0);
+            for (vertices_size_type v = 0; v != n; ++v) {
+                std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(v, g), g);
+                _targets.insert(_targets.end(), p.first, p.second);
+                _offsets.push_back(_targets.size());}
+            assert(valid());}
+
+        // Default copy, destructor, and copy assignment
+    };
+
+typedef BasicGraphCSR<> GraphCSR;
+
+// -----------
+// GraphHeader
+// -----------
+
+/**
+ * leads every file written by save
+ * the file continues with num_vertices + 1 uint64_t offsets and num_edges vertex_descriptor targets,
+ * in native byte order, so that GraphMapped can serve them straight from the page cache
+ */
+struct GraphHeader {
+    static const uint32_t version_number = 1;
+
+    char     magic[8];      // "GRAPHCSR"
+    uint32_t version;       // version_number
+    uint32_t vertex_size;   // sizeof(vertex_descriptor)
+    uint64_t num_vertices;
+    uint64_t num_edges;
+
+    /**
+     * @param vertex_size is the size of the graph's vertex_descriptor
+     */
+    explicit GraphHeader (uint32_t vertex_size = sizeof(Graph::vertex_descriptor)) :
+            version      (version_number),
+            vertex_size  (vertex_size),
+            num_vertices (0),
+            num_edges    (0) {
+        std::memcpy(magic, "GRAPHCSR", sizeof(magic));}
+
+    /**
+     * @param size   is the size of the file in bytes
+     * @param expect is the size of the reader's vertex_descriptor
+     * return true if this header was written by this version of save, for vertex_descriptors of size expect, and fits in size bytes
+     */
+    bool valid (uint64_t size, uint32_t expect) const {
+        const GraphHeader h(expect);
+        if ((std::memcmp(magic, h.magic, sizeof(magic)) != 0) || (version != h.version) || (vertex_size != h.vertex_size))
+            return false;
+        if ((num_vertices >= (size / sizeof(uint64_t))) || (num_edges > (size / vertex_size)))
+            return false;
+        return size == sizeof(GraphHeader) + ((num_vertices + 1) * sizeof(uint64_t)) + (num_edges * vertex_size);}};
+
+// ---------
+// temp_path
+// ---------
+
+/**
+ * @param path is a file about to be written
+ * return a name beside path that no other save, in this process or another, is writing at the same time
+ */
+inline std::string temp_path (const std::string& path) {
+    static std::atomic<unsigned long> n(0);
+    return path + ".tmp" + std::to_string(::getpid()) + "." + std::to_string(n.fetch_add(1));}
+
+// ----
+// save
+// ----
+
+/**
+ * @param g    is a graph by reference, Graph or any compressed-sparse-row view
+ * @param path is the file to write
+ * write g in the GraphHeader format to a temporary file beside path, then rename it over path,
+ * so a process that has the old file mapped keeps reading it whole
+ * return true if the whole file was written and renamed
+ */
+template <typename G>
+bool save (const G& g, const std::string& path) {
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+
+    const std::string tmp = temp_path(path);
+    std::ofstream out(tmp.c_str(), std::ios::binary | std::ios::trunc);
+    GraphHeader h(sizeof(vertex_descriptor));
+    h.num_vertices = num_vertices(g);
+    h.num_edges    = num_edges(g);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+    uint64_t o = 0;
+    out.write(reinterpret_cast<const char*>(&o), sizeof(o));
+    for (uint64_t v = 0; v != h.num_vertices; ++v) {
+        std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(v, g), g);
+        o += std::distance(p.first, p.second);
+        out.write(reinterpret_cast<const char*>(&o), sizeof(o));}
+    assert(o == h.num_edges);
+
+    for (uint64_t v = 0; v != h.num_vertices; ++v) {
+        std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(v, g), g);
+        for (; p.first != p.second; ++p.first) {
+            const vertex_descriptor w = *p.first;
+            out.write(reinterpret_cast<const char*>(&w), sizeof(w));}}
+    out.close();
+    if (out.fail() || (std::rename(tmp.c_str(), path.c_str()) != 0)) {
+        std::remove(tmp.c_str());
+        return false;}
+    return true;}
+
+// -----------
+// GraphMapped
+// -----------
+
+/**
+ * read-only graph served from a file written by save, mapped shared and read-only,
+ * so loading touches no pages and every process mapping the file shares one copy
+ * V is the vertex index type, which must be the one the file was saved with
+ * a file that cannot be opened or has a bad header maps as the empty graph, and is_open returns false
+ * only the header and the first and last offsets are checked when mapping; the rest of the file is trusted,
+ * so call verify before reading a file that may have been corrupted
+ */
+template <typename V = int>
+class BasicGraphMapped {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef typename BasicGraphCSR<V>::vertex_descriptor  vertex_descriptor;
+        typedef typename BasicGraphCSR<V>::edge_descriptor    edge_descriptor;
+
+        typedef typename BasicGraphCSR<V>::vertex_iterator    vertex_iterator;
+        typedef typename BasicGraphCSR<V>::edge_iterator      edge_iterator;
+        typedef const vertex_descriptor*                      adjacency_iterator;
+
+        typedef typename BasicGraphCSR<V>::vertices_size_type vertices_size_type;
+        typedef typename BasicGraphCSR<V>::edges_size_type    edges_size_type;
+
+    public:
+        // -----------------
+        // adjacent_vertices
+        // -----------------
+
+        /**
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphMapped by reference
+         * return a pair of pointers into the mapped, sorted targets of v in g
+         */
+        friend std::pair<adjacency_iterator, adjacency_iterator> adjacent_vertices (vertex_descriptor v, const BasicGraphMapped& g) {
+            return std::make_pair(g._targets + g._offsets[v], g._targets + g._offsets[v + 1]);}
+
+        // ----
+        // edge
+        // ----
+
+        /**
+         * @param u is a vertex_descriptor by value
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphMapped by reference
+         * return pair<edge_descriptor, bool> bool will be true if edge in g
+         * binary search over the targets of u, O(log deg(u))
+         */
+        friend std::pair<edge_descriptor, bool> edge (vertex_descriptor u, vertex_descriptor v, const BasicGraphMapped& g) {
+            edge_descriptor ed = std::make_pair(u, v);
+            bool            b  = false;
+            if ((u >= 0) && (static_cast<vertices_size_type>(u) < num_vertices(g))) {
+                std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+                b = std::binary_search(p.first, p.second, v);}
+            return std::make_pair(ed, b);}
+
+        // -----
+        // edges
+        // -----
+
+        /**
+         * @param g is a GraphMapped by reference
+         * return pair of begin and end iterators over edges in g, ordered by (source, target)
+         */
+        friend std::pair<edge_iterator, edge_iterator> edges (const BasicGraphMapped& g) {
+            edge_iterator b(g._offsets, g._targets, g._n, 0,    0);
+            edge_iterator e(g._offsets, g._targets, g._n, g._n, g._offsets[g._n]);
+            return std::make_pair(b, e);}
+
+        // ---------
+        // num_edges
+        // ---------
+
+        /**
+         * @param g is a GraphMapped by reference
+         * return number of edges in g
+         */
+        friend edges_size_type num_edges (const BasicGraphMapped& g) {
+            return g._offsets[g._n];}
+
+        // ------------
+        // num_vertices
+        // ------------
+
+        /**
+         * @param g is a GraphMapped by reference
+         * return number of vertices in g
+         */
+        friend vertices_size_type num_vertices (const BasicGraphMapped& g) {
+            return g._n;}
+
+        // ------
+        // source
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * @param g is a GraphMapped by reference
+         * return vertex_descriptor of source
+         */
+        friend vertex_descriptor source (edge_descriptor ed, const BasicGraphMapped&) {
+            return ed.first;}
+
+        // ------
+        // target
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * @param g is a GraphMapped by reference
+         * return vertex_descriptor of target
+         */
+        friend vertex_descriptor target (edge_descriptor ed, const BasicGraphMapped&) {
+            return ed.second;}
+
+        // ------
+        // vertex
+        // ------
+
+        /**
+         * @param vs is a vertices_size_type by value
+         * @param g is a GraphMapped by reference
+         * return vertex_descriptor of vertex
+         */
+        friend vertex_descriptor vertex (vertices_size_type vs, const BasicGraphMapped&) {
+            return vs;}
+
+        // --------
+        // vertices
+        // --------
+
+        /**
+         * @param g is a GraphMapped by reference
+         * return begin and end iterators over the vertices of g
+         */
+        friend std::pair<vertex_iterator, vertex_iterator> vertices (const BasicGraphMapped& g) {
+            return std::make_pair(vertex_iterator(0), vertex_iterator(g._n));}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        void*                    _map;     // the mapping, 0 when nothing is mapped
+        std::size_t              _size;    // its length in bytes
+        vertices_size_type       _n;
+        const edges_size_type*   _offsets; // into the mapping, or empty()
+        const vertex_descriptor* _targets; // into the mapping, or 0
+
+        static const edges_size_type* empty () {
+            static const edges_size_type x = 0;
+            return &x;}
+
+        void clear () {
+            _map     = 0;
+            _size    = 0;
+            _n       = 0;
+            _offsets = empty();
+            _targets = 0;}
+
+        // -----
+        // valid
+        // -----
+
+        /**
+         * offsets start at 0 and end at the number of edges
+         */
+        bool valid () const {
+            return (_offsets[0] == 0) && ((_map == 0) || (_size == sizeof(GraphHeader) + ((_n + 1) * sizeof(uint64_t)) + (_offsets[_n] * sizeof(vertex_descriptor))));}
+
+        BasicGraphMapped             (const BasicGraphMapped&);
+        BasicGraphMapped& operator = (const BasicGraphMapped&);
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * @param path is a file written by save
+         * map path read-only; nothing is read beyond the header until it is used
+         */
+        explicit BasicGraphMapped (const std::string& path) {
+            static_assert(sizeof(edges_size_type) == sizeof(uint64_t), "offsets are stored as uint64_t");
+            clear();
+            const int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd == -1)
+                return;
+            struct stat st;
+            if ((::fstat(fd, &st) == 0) && (static_cast<uint64_t>(st.st_size) >= sizeof(GraphHeader))) {
+                void* p = ::mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (p != MAP_FAILED) {
+                    const GraphHeader& h = *static_cast<const GraphHeader*>(p);
+                    const uint64_t*    o = reinterpret_cast<const uint64_t*>(static_cast<const char*>(p) + sizeof(GraphHeader));
+                    // the header fits the file size, and the first and last offsets, a page or two, fit the header
+                    if (h.valid(st.st_size, sizeof(vertex_descriptor)) && ((h.num_vertices == 0) || ((h.num_vertices - 1) <= static_cast<uint64_t>(std::numeric_limits<vertex_descriptor>::max()))) &&
+                        (o[0] == 0) && (o[h.num_vertices] == h.num_edges)) {
+                        _map     = p;
+                        _size    = st.st_size;
+                        _n       = h.num_vertices;
+                        _offsets = reinterpret_cast<const edges_size_type*>(static_cast<const char*>(p) + sizeof(GraphHeader));
+                        _targets = reinterpret_cast<const vertex_descriptor*>(_offsets + _n + 1);}
+                    else
+                        ::munmap(p, st.st_size);}}
+            ::close(fd);
+            assert(valid());}
+
+        BasicGraphMapped (BasicGraphMapped&& that) :
+                _map     (that._map),
+                _size    (that._size),
+                _n       (that._n),
+                _offsets (that._offsets),
+                _targets (that._targets) {
+            that.clear();}
+
+        ~BasicGraphMapped () {
+            if (_map != 0)
+                ::munmap(_map, _size);}
+
+        // -------
+        // is_open
+        // -------
+
+        /**
+         * return true if a file was mapped
+         */
+        bool is_open () const {
+            return _map != 0;}
+
+        // ------
+        // verify
+        // ------
+
+        /**
+         * return true if the offsets never decrease and every target is a vertex of the graph,
+         * that is, if every read through the graph stays in the file; O(V + E), touches every page
+         */
+        bool verify () const {
+            for (vertices_size_type v = 0; v != _n; ++v)
+                if (_offsets[v] > _offsets[v + 1])
+                    return false;
+            for (edges_size_type i = 0; i != _offsets[_n]; ++i)
+                if ((_targets[i] < 0) || (static_cast<vertices_size_type>(_targets[i]) >= _n))
+                    return false;
+            return true;}
+    };
+
+typedef BasicGraphMapped<> GraphMapped;
+
+// ------------
+// BoundedQueue
+// ------------
+
+/**
+ * blocking queue of at most capacity items, used to hand work between pipeline stages
+ * push blocks while full; pop blocks while empty and returns false once closed and drained
+ */
+template <typename T>
+class BoundedQueue {
+    private:
+        std::deque<T>           _q;
+        std::size_t             _capacity;
+        bool                    _closed;
+        std::mutex              _m;
+        std::condition_variable _not_empty;
+        std::condition_variable _not_full;
+
+    public:
+        explicit BoundedQueue (std::size_t capacity) :
+                _q        (),
+                _capacity (std::max<std::size_t>(capacity, 1)),
+                _closed   (false)
+            {}
+
+        void push (T x) {
+            std::unique_lock<std::mutex> l(_m);
+            _not_full.wait(l, [this] () {return _q.size() < _capacity;});
+            _q.push_back(std::move(x));
+            _not_empty.notify_one();}
+
+        bool pop (T& x) {
+            std::unique_lock<std::mutex> l(_m);
+            _not_empty.wait(l, [this] () {return _closed || !_q.empty();});
+            if (_q.empty())
+                return false;
+            x = std::move(_q.front());
+            _q.pop_front();
+            _not_full.notify_one();
+            return true;}
+
+        void close () {
+            std::lock_guard<std::mutex> l(_m);
+            _closed = true;
+            _not_empty.notify_all();}};
+
+// --------------
+// GraphReadStats
+// --------------
+
+/**
+ * what read_edges saw and did
+ */
+struct GraphReadStats {
+    uint64_t bytes;     // bytes read
+    uint64_t edges;     // lines parsed as an edge
+    uint64_t added;     // edges new to the graph
+    uint64_t rejected;  // lines that were neither an edge, a comment, nor blank
+    double   seconds;   // wall time
+    bool     complete;  // the input was read to its end without a stream error
+    uint32_t parsers;   // parsing threads
+
+    GraphReadStats () :
+            bytes    (0),
+            edges    (0),
+            added    (0),
+            rejected (0),
+            seconds  (0),
+            complete (false),
+            parsers  (0)
+        {}
+
+    double edges_per_second () const {
+        return (seconds > 0) ? (edges / seconds) : 0;}
+
+    friend std::ostream& operator << (std::ostream& lhs, const GraphReadStats& rhs) {
+        return lhs << "edges "     << rhs.edges
+                   << " added "    << rhs.added
+                   << " rejected " << rhs.rejected
+                   << " bytes "    << rhs.bytes
+                   << " seconds "  << rhs.seconds
+                   << " edges/s "  << rhs.edges_per_second()
+                   << " parsers "  << rhs.parsers;}};
+
+// ----------
+// parse_edge
+// ----------
+
+/**
+ * @param b         is the first character of a line
+ * @param e         is past its last character, excluding the newline
+ * @param one_based is true if vertices are numbered from 1
+ * @param ed        is where the edge goes
+ * return 1 for an edge, 0 for a blank or comment line, -1 for anything else
+ * an edge is two non-negative integers, each at most the largest V, separated by spaces or tabs;
+ * later columns, such as weights, are ignored
+ */
+template <typename V>
+int parse_edge (const char* b, const char* e, bool one_based, std::pair<V, V>& ed) {
+    while ((b != e) && ((*b == ' ') || (*b == '\t') || (*b == '\r')))
+        ++b;
+    if ((b == e) || (*b == '#') || (*b == '%'))
+        return 0;
+    const uint64_t max = std::numeric_limits<V>::max();
+    V              x[2];
+    for (int i = 0; i != 2; ++i) {
+        if (i != 0) {
+            const char* c = b;
+            while ((b != e) && ((*b == ' ') || (*b == '\t')))
+                ++b;
+            if (b == c)
+                return -1;}
+        if ((b == e) || (*b < '0') || (*b > '9'))
+            return -1;
+        uint64_t n = 0;
+        for (; (b != e) && (*b >= '0') && (*b <= '9'); ++b) {
+            const unsigned d = *b - '0';
+            if (n > ((max - d) / 10))
+                return -1;
+            n = (n * 10) + d;}
+        if (one_based && (n-- == 0))
+            return -1;
+        x[i] = static_cast<V>(n);}
+    if ((b != e) && (*b != ' ') && (*b != '\t') && (*b != '\r'))
+        return -1;
+    ed = std::make_pair(x[0], x[1]);
+    return 1;}
+
+// ---------
+// next_line
+// ---------
+
+/**
+ * @param s is a string by reference
+ * @param i is an index into s
+ * return the index just past the newline ending the line at i, or npos if that line is unterminated
+ */
+inline std::size_t next_line (const std::string& s, std::size_t i) {
+    const std::size_t j = s.find('\n', i);
+    return (j == std::string::npos) ? j : (j + 1);}
+
+// ----------
+// read_edges
+// ----------
+
+/**
+ * @param in         is a whitespace- or tab-separated edge list, one edge per line
+ * @param g          is a graph by reference, a BasicGraph of any vertex type
+ * @param n_threads  is the number of parsing threads, 0 for one per core
+ * @param chunk_size is the number of bytes handed to a parser at a time
+ * add every edge in in to g; lines starting with # or % are comments
+ * a %%MatrixMarket banner makes the vertices one-based and skips the size line
+ * the input is read in chunks by this thread, parsed by n_threads threads, and inserted with add_edges
+ * by one more, all at once; the queues between them hold a few chunks, so memory does not grow with the input
+ * return the counts and throughput of the load
+ */
+template <typename V, typename A>
+GraphReadStats read_edges (std::istream& in, BasicGraph<V, A>& g, std::size_t n_threads = 0, std::size_t chunk_size = 1 << 20) {
+    typedef typename BasicGraph<V, A>::edge_descriptor edge_descriptor;
+    typedef std::vector<edge_descriptor>               batch_type;
+
+    const std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    // the length of the input is unknown, so take as many parsers as asked, or one per core
+    const std::size_t n_parsers = default_threads(n_threads, std::numeric_limits<std::size_t>::max(), 1);
+    const std::size_t n_batch   = std::max<std::size_t>(chunk_size, 1 << 16);
+
+    GraphReadStats           stats;
+    BoundedQueue<std::string> chunks(2 * n_parsers);
+    BoundedQueue<batch_type>  batches(2 * n_parsers);
+    std::atomic<uint64_t>     edges(0);
+    std::atomic<uint64_t>     rejected(0);
+    std::atomic<std::size_t>  running(n_parsers);
+    bool                      one_based = false;
+
+    std::vector<std::thread> parsers;
+    for (std::size_t t = 0; t != n_parsers; ++t)
+        parsers.push_back(std::thread([&] () {
+            std::string s;
+            while (chunks.pop(s)) {
+                batch_type  x;
+                uint64_t    r = 0;
+                const char* b = s.data();
+                const char* e = b + s.size();
+                while (b != e) {
+                    const char* c = std::find(b, e, '\n');
+                    edge_descriptor ed;
+                    const int       k = parse_edge(b, c, one_based, ed);
+                    if (k == 1)
+                        x.push_back(ed);
+                    r += (k == -1);
+                    b = (c == e) ? c : (c + 1);}
+                edges    += x.size();
+                rejected += r;
+                batches.push(std::move(x));}
+            if (--running == 0)
+                batches.close();}));
+
+    std::thread builder([&] () {
+        batch_type x;
+        batch_type y;
+        while (batches.pop(y)) {
+            x.insert(x.end(), y.begin(), y.end());
+            if (x.size() >= n_batch) {
+                stats.added += add_edges(x.begin(), x.end(), g, 1);
+                x.clear();}}
+        stats.added += add_edges(x.begin(), x.end(), g, 1);});
+
+    const std::string banner = "%%MatrixMarket";
+    std::string       carry;
+    std::vector<char> buffer(std::max<std::size_t>(chunk_size, 1));
+    bool              header = true;
+    while (in) {
+        in.read(&buffer[0], buffer.size());
+        const std::size_t n = in.gcount();
+        stats.bytes += n;
+        carry.append(&buffer[0], n);
+        if (header) {
+            // a MatrixMarket file is one-based, and its first line after the comments is the matrix size
+            std::size_t i = 0;
+            if (carry.compare(0, banner.size(), banner) == 0) {
+                while ((i < carry.size()) && (carry[i] == '%'))
+                    i = next_line(carry, i);
+                i = (i < carry.size()) ? next_line(carry, i) : std::string::npos;}
+            else if ((carry.size() < banner.size()) && (banner.compare(0, carry.size(), carry) == 0))
+                i = std::string::npos;
+            if ((i == std::string::npos) && !in.eof())
+                continue;
+            one_based = (carry.compare(0, banner.size(), banner) == 0);
+            header    = false;
+            carry.erase(0, std::min(i, carry.size()));}
+        const std::size_t j = carry.rfind('\n');
+        const std::size_t k = in.eof() ? carry.size() : (j == std::string::npos) ? 0 : (j + 1);
+        if (k != 0) {
+            chunks.push(carry.substr(0, k));
+            carry.erase(0, k);}}
+    chunks.close();
+
+    for (std::size_t t = 0; t != n_parsers; ++t)
+        parsers[t].join();
+    builder.join();
+
+    stats.edges    = edges;
+    stats.rejected = rejected;
+    stats.complete = in.eof() && !in.bad();
+    stats.parsers  = n_parsers;
+    stats.seconds  = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return stats;}
+
+/**
+ * @param path       is the file to read
+ * @param g          is a graph by reference, a BasicGraph of any vertex type
+ * @param n_threads  is the number of parsing threads, 0 for one per core
+ * @param chunk_size is the number of bytes handed to a parser at a time
+ * return the counts and throughput of the load; complete is false if path cannot be read
+ */
+template <typename V, typename A>
+GraphReadStats read_edges (const std::string& path, BasicGraph<V, A>& g, std::size_t n_threads = 0, std::size_t chunk_size = 1 << 20) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    return read_edges(in, g, n_threads, chunk_size);}
+
+// --------
+// GraphBFS
+// --------
+
+/**
+ * parallel, direction-optimizing breadth-first search
+ * keeps its own compressed-sparse-row copy of the graph and of its transpose, so that a level can
+ * either push from the frontier along out-edges (top-down) or, once the frontier is large, let every
+ * unvisited vertex pull along its in-edges until it finds a frontier vertex (bottom-up)
+ * visited vertices stay visited across calls to run until reset, so runs from several sources partition the graph
+ * V is the vertex index type of the graphs searched; where -1 marks a vertex below, it is V(-1), the largest V when V is unsigned
+ */
+template <typename V = int>
+class BasicGraphBFS {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef V           vertex_descriptor;
+        typedef std::size_t vertices_size_type;
+        typedef std::size_t edges_size_type;
+
+    private:
+        // ---------
+        // constants
+        // ---------
+
+        // switch to bottom-up when the frontier's edges exceed 1 / alpha of the unexplored edges,
+        // and back to top-down when the frontier holds fewer than 1 / beta of the vertices
+        static const int alpha = 14;
+        static const int beta  = 24;
+
+        typedef std::vector< std::atomic<uint64_t> > bitmap_type;
+
+        // ----
+        // data
+        // ----
+
+        vertices_size_type             _n;
+        edges_size_type                _m;
+        std::size_t                    _n_threads;
+        std::vector<edges_size_type>   _out_offsets;
+        std::vector<vertex_descriptor> _out_targets;
+        std::vector<edges_size_type>   _in_offsets;
+        std::vector<vertex_descriptor> _in_targets;
+        bitmap_type                    _visited;
+        bitmap_type                    _front;       // the frontier, while searching bottom-up
+        bitmap_type                    _next;
+        std::vector<vertex_descriptor> _parent;
+        std::vector<vertex_descriptor> _depth;
+        std::vector<vertex_descriptor> _root;
+
+        // per-level scratch, kept across levels and runs
+        std::vector<vertex_descriptor>                _frontier;
+        std::vector< std::vector<vertex_descriptor> > _local;   // the vertices each thread reached, top-down
+        std::vector<vertices_size_type>               _counts;
+        std::vector<edges_size_type>                  _degrees;
+
+        // ------
+        // bitmap
+        // ------
+
+        static bool test (const bitmap_type& b, vertex_descriptor v) {
+            return (b[v >> 6].load(std::memory_order_relaxed) >> (v & 63)) & 1;}
+
+        /**
+         * return true if this call set the bit
+         */
+        static bool set (bitmap_type& b, vertex_descriptor v) {
+            const uint64_t k = uint64_t(1) << (v & 63);
+            return !(b[v >> 6].fetch_or(k, std::memory_order_relaxed) & k);}
+
+        static void clear (bitmap_type& b) {
+            for (std::size_t i = 0; i != b.size(); ++i)
+                b[i].store(0, std::memory_order_relaxed);}
+
+        // -------------
+        // build_reverse
+        // -------------
+
+        /**
+         * fill the in-edges from the out-edges, in parallel
+         */
+        void build_reverse (std::vector<edges_size_type>& offsets, std::vector<vertex_descriptor>& targets) const {
+            std::vector< std::atomic<edges_size_type> > next(_n + 1);
+            for (std::size_t v = 0; v <= _n; ++v)
+                next[v].store(0, std::memory_order_relaxed);
+            parallel_chunks(_n, _n_threads, 1 << 10, [&] (std::size_t, std::size_t b, std::size_t e) {
+                for (std::size_t i = _out_offsets[b]; i != _out_offsets[e]; ++i)
+                    next[_out_targets[i]].fetch_add(1, std::memory_order_relaxed);});
+            offsets.assign(_n + 1, 0);
+            for (std::size_t v = 0; v != _n; ++v) {
+                offsets[v + 1] = offsets[v] + next[v].load(std::memory_order_relaxed);
+                next[v].store(offsets[v], std::memory_order_relaxed);}
+            targets.resize(_m);
+            parallel_chunks(_n, _n_threads, 1 << 10, [&] (std::size_t, std::size_t b, std::size_t e) {
+                for (std::size_t u = b; u != e; ++u)
+                    for (std::size_t i = _out_offsets[u]; i != _out_offsets[u + 1]; ++i)
+                        targets[next[_out_targets[i]].fetch_add(1, std::memory_order_relaxed)] = u;});}
+
+        // -----
+        // visit
+        // -----
+
+        void visit (vertex_descriptor v, vertex_descriptor u, vertex_descriptor d, vertex_descriptor s) {
+            _parent[v] = u;
+            _depth[v]  = d;
+            _root[v]   = s;}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * @param g         is a graph by reference
+         * @param n_threads is the number of threads, 0 for one per core
+         */
+        template <typename G>
+        explicit BasicGraphBFS (const G& g, std::size_t n_threads = 0) :
+                _n         (num_vertices(g)),
+                _m         (0),
+                _n_threads (default_threads(n_threads, num_vertices(g), 1 << 10)),
+                _visited   ((num_vertices(g) + 63) / 64),
+                _front     ((num_vertices(g) + 63) / 64),
+                _next      ((num_vertices(g) + 63) / 64),
+                _local     (_n_threads),
+                _counts    (_n_threads),
+                _degrees   (_n_threads) {
+            typedef typename G::adjacency_iterator adjacency_iterator;
+            _out_offsets.reserve(_n + 1);
+            _out_targets.reserve(num_edges(g));
+            _out_offsets.push_back(0);
+            for (std::size_t v = 0; v != _n; ++v) {
+                std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(v, g), g);
+                _out_targets.insert(_out_targets.end(), p.first, p.second);
+                _out_offsets.push_back(_out_targets.size());}
+            _m = _out_targets.size();
+            build_reverse(_in_offsets, _in_targets);
+            reset();}
+
+        // -----
+        // reset
+        // -----
+
+        /**
+         * mark every vertex unvisited, O(V); the graph is not copied again, so one engine can answer many searches
+         */
+        void reset () {
+            clear(_visited);
+            _parent.assign(_n, static_cast<vertex_descriptor>(-1));
+            _depth.assign(_n, static_cast<vertex_descriptor>(-1));
+            _root.assign(_n, static_cast<vertex_descriptor>(-1));}
+
+        // ---
+        // run
+        // ---
+
+        /**
+         * @param s       is the source
+         * @param reverse is true to follow edges backwards
+         * search from s through the vertices not yet visited; s is its own parent at depth 0
+         * return the number of vertices reached, 0 if s was already visited
+         */
+        vertices_size_type run (vertex_descriptor s, bool reverse = false) {
+            const std::vector<edges_size_type>&   fo = reverse ? _in_offsets  : _out_offsets;
+            const std::vector<vertex_descriptor>& ft = reverse ? _in_targets  : _out_targets;
+            const std::vector<edges_size_type>&   bo = reverse ? _out_offsets : _in_offsets;
+            const std::vector<vertex_descriptor>& bt = reverse ? _out_targets : _in_targets;
+
+            if (!set(_visited, s))
+                return 0;
+            visit(s, s, 0, s);
+
+            std::vector<vertex_descriptor>&  frontier  = _frontier;
+            std::vector<vertices_size_type>& counts    = _counts;
+            std::vector<edges_size_type>&    degrees   = _degrees;
+            frontier.assign(1, s);
+            bitmap_type&                   front     = _front;
+            bitmap_type&                   next      = _next;
+            vertices_size_type             n_f       = 1;
+            vertices_size_type             reached   = 1;
+            edges_size_type                m_f       = fo[s + 1] - fo[s];
+            edges_size_type                m_u       = _m;
+            bool                           bottom_up = false;
+
+            for (vertex_descriptor d = 1; n_f != 0; ++d) {
+                if (!bottom_up && (m_f > (m_u / alpha))) {
+                    clear(front);
+                    for (std::size_t i = 0; i != frontier.size(); ++i)
+                        set(front, frontier[i]);
+                    bottom_up = true;}
+                else if (bottom_up && (n_f < (_n / beta))) {
+                    frontier.clear();
+                    for (std::size_t v = 0; v != _n; ++v)
+                        if (test(front, v))
+                            frontier.push_back(v);
+                    bottom_up = false;}
+                m_u -= std::min(m_u, m_f);
+
+                std::fill(counts.begin(),  counts.end(),  0);
+                std::fill(degrees.begin(), degrees.end(), 0);
+                if (!bottom_up) {
+                    std::vector< std::vector<vertex_descriptor> >& x = _local;
+                    for (std::size_t t = 0; t != _n_threads; ++t)
+                        x[t].clear();
+                    parallel_chunks(frontier.size(), _n_threads, 64, [&] (std::size_t t, std::size_t b, std::size_t e) {
+                        for (; b != e; ++b) {
+                            const vertex_descriptor u = frontier[b];
+                            for (std::size_t i = fo[u]; i != fo[u + 1]; ++i) {
+                                const vertex_descriptor w = ft[i];
+                                if (!test(_visited, w) && set(_visited, w)) {
+                                    visit(w, u, d, s);
+                                    x[t].push_back(w);
+                                    degrees[t] += fo[w + 1] - fo[w];}}}});
+                    frontier.clear();
+                    for (std::size_t t = 0; t != _n_threads; ++t) {
+                        frontier.insert(frontier.end(), x[t].begin(), x[t].end());
+                        counts[t] = x[t].size();}}
+                else {
+                    clear(next);
+                    // threads own whole words, so no two threads visit vertices in the same word
+                    parallel_chunks(front.size(), _n_threads, 16, [&] (std::size_t t, std::size_t b, std::size_t e) {
+                        const std::size_t ve = std::min<std::size_t>(e * 64, _n);
+                        for (std::size_t v = b * 64; v != ve; ++v) {
+                            if (test(_visited, v))
+                                continue;
+                            for (std::size_t i = bo[v]; i != bo[v + 1]; ++i) {
+                                const vertex_descriptor u = bt[i];
+                                if (test(front, u)) {
+                                    set(_visited, v);
+                                    set(next, v);
+                                    visit(v, u, d, s);
+                                    ++counts[t];
+                                    degrees[t] += fo[v + 1] - fo[v];
+                                    break;}}}});
+                    front.swap(next);}
+
+                n_f = 0;
+                m_f = 0;
+                for (std::size_t t = 0; t != _n_threads; ++t) {
+                    n_f += counts[t];
+                    m_f += degrees[t];}
+                reached += n_f;}
+            return reached;}
+
+        // -------
+        // visited
+        // -------
+
+        bool visited (vertex_descriptor v) const {
+            return test(_visited, v);}
+
+        // -------
+        // threads
+        // -------
+
+        /**
+         * return the number of threads a run uses: as asked, but no more than one per 1024 vertices
+         */
+        std::size_t threads () const {
+            return _n_threads;}
+
+        // ----------
+        // accessors
+        // ----------
+
+        /**
+         * return the vertex each vertex was reached from, -1 if unvisited
+         */
+        const std::vector<vertex_descriptor>& parent () const {
+            return _parent;}
+
+        /**
+         * return the number of levels from its source to each vertex, -1 if unvisited
+         */
+        const std::vector<vertex_descriptor>& depth () const {
+            return _depth;}
+
+        /**
+         * return the source of the run that reached each vertex, -1 if unvisited
+         */
+        const std::vector<vertex_descriptor>& root () const {
+            return _root;}
+
+        // -------
+        // degrees
+        // -------
+
+        edges_size_type out_degree (vertex_descriptor v) const {
+            return _out_offsets[v + 1] - _out_offsets[v];}
+
+        edges_size_type in_degree (vertex_descriptor v) const {
+            return _in_offsets[v + 1] - _in_offsets[v];}
+
+        std::pair<const vertex_descriptor*, const vertex_descriptor*> out_edges (vertex_descriptor v) const {
+            return std::make_pair(_out_targets.data() + _out_offsets[v], _out_targets.data() + _out_offsets[v + 1]);}};
+
+typedef BasicGraphBFS<> GraphBFS;
+
+// --------------------
+// breadth_first_search
+// --------------------
+
+/**
+ * @param g         is a graph by reference
+ * @param s         is the source
+ * @param parent    is set to the vertex each vertex was reached from, s for s, -1 if unreachable
+ * @param depth     is set to the number of edges from s to each vertex, -1 if unreachable
+ * @param n_threads is the number of threads, 0 for one per core
+ * return the number of vertices reachable from s
+ */
+template <typename G>
+typename G::vertices_size_type breadth_first_search (const G& g, typename G::vertex_descriptor s, std::vector<typename G::vertex_descriptor>& parent, std::vector<typename G::vertex_descriptor>& depth, std::size_t n_threads = 0) {
+    BasicGraphBFS<typename G::vertex_descriptor> b(g, n_threads);
+    return breadth_first_search(b, s, parent, depth);}
+
+/**
+ * @param b      is a GraphBFS by reference, built once and reused across searches
+ * @param s      is the source
+ * @param parent is set to the vertex each vertex was reached from, s for s, -1 if unreachable
+ * @param depth  is set to the number of edges from s to each vertex, -1 if unreachable
+ * the search costs O(V) to reset b rather than O(V + E) to copy the graph again
+ * return the number of vertices reachable from s
+ */
+template <typename V>
+typename BasicGraphBFS<V>::vertices_size_type breadth_first_search (BasicGraphBFS<V>& b, V s, std::vector<V>& parent, std::vector<V>& depth) {
+    b.reset();
+    const typename BasicGraphBFS<V>::vertices_size_type n = b.run(s);
+    parent = b.parent();
+    depth  = b.depth();
+    return n;}
+
+// --------------
+// relabel_labels
+// --------------
+
+/**
+ * @param c is a component label per vertex, renumbered in place
+ * number the components 0, 1, ... in order of their smallest vertex
+ * return the number of components
+ */
+template <typename V>
+std::size_t relabel_labels (std::vector<V>& c) {
+    const std::size_t        none = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> x(c.size(), none);
+    std::size_t              k = 0;
+    for (std::size_t v = 0; v != c.size(); ++v) {
+        if (x[c[v]] == none)
+            x[c[v]] = k++;
+        c[v] = x[c[v]];}
+    return k;}
+
+// ---------------------------
+// weakly_connected_components
+// ---------------------------
+
+/**
+ * @param g         is a graph by reference
+ * @param component is set to the component of each vertex, numbered in order of each component's smallest vertex
+ * @param n_threads is the number of threads, 0 for one per core
+ * a concurrent union-find over the edges of g as it is, without copying it: each edge joins the roots
+ * of its ends, the larger root hooked under the smaller with a compare-and-swap, and finds halve their paths
+ * return the number of weakly connected components
+ */
+template <typename G>
+typename G::vertices_size_type weakly_connected_components (const G& g, std::vector<typename G::vertex_descriptor>& component, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::size_t                             n = num_vertices(g);
+    std::vector< std::atomic<vertex_descriptor> > p(n);
+    for (std::size_t v = 0; v != n; ++v)
+        p[v].store(v, std::memory_order_relaxed);
+
+    // a parent is never larger than its child, so a root is the smallest vertex of its tree
+    auto find = [&] (vertex_descriptor v) {
+        vertex_descriptor u = p[v].load(std::memory_order_relaxed);
+        while (u != v) {
+            vertex_descriptor w = p[u].load(std::memory_order_relaxed);
+            p[v].compare_exchange_weak(u, w, std::memory_order_relaxed);
+            v = w;
+            u = p[v].load(std::memory_order_relaxed);}
+        return v;};
+
+    parallel_chunks(n, default_threads(n_threads, n, 1 << 10), 1 << 10, [&] (std::size_t, std::size_t b, std::size_t e) {
+        for (std::size_t v = b; v != e; ++v) {
+            std::pair<adjacency_iterator, adjacency_iterator> q = adjacent_vertices(vertex(v, g), g);
+            for (; q.first != q.second; ++q.first) {
+                vertex_descriptor x = find(v);
+                vertex_descriptor y = find(*q.first);
+                while (x != y) {
+                    if (x < y)
+                        std::swap(x, y);
+                    vertex_descriptor r = x;
+                    if (p[x].compare_exchange_strong(r, y, std::memory_order_relaxed))
+                        break;
+                    x = find(x);
+                    y = find(y);}}}});
+
+    component.resize(n);
+    for (std::size_t v = 0; v != n; ++v)
+        component[v] = find(v);
+    return relabel_labels(component);}
+
+// -----------------------------
+// strongly_connected_components
+// -----------------------------
+
+/**
+ * @param g         is a graph by reference
+ * @param component is set to the component of each vertex, numbered in order of each component's smallest vertex
+ * @param n_threads is the number of threads, 0 for one per core
+ * the component of the vertex with the largest in-degree times out-degree, usually the giant one, is
+ * the intersection of a parallel forward and a parallel backward search from it; the rest of the graph
+ * is finished by an iterative Tarjan search that ignores that component
+ * return the number of strongly connected components
+ */
+template <typename G>
+typename G::vertices_size_type strongly_connected_components (const G& g, std::vector<typename G::vertex_descriptor>& component, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor vertex_descriptor;
+    typedef typename G::vertices_size_type vertices_size_type;
+    const vertices_size_type n    = num_vertices(g);
+    const vertices_size_type none = static_cast<vertices_size_type>(-1);
+    component.assign(n, 0);
+    if (n == 0)
+        return 0;
+
+    // any label, the largest vertex included, is a component, so which vertices have one is kept apart
+    std::vector<char> done(n, 0);
+
+    BasicGraphBFS<vertex_descriptor> b(g, n_threads);
+    vertex_descriptor                p = 0;
+    for (vertices_size_type v = 1; v != n; ++v)
+        if ((b.in_degree(v) * b.out_degree(v)) > (b.in_degree(p) * b.out_degree(p)))
+            p = v;
+    b.run(p);
+    std::vector<char> forward(n);
+    for (vertices_size_type v = 0; v != n; ++v)
+        forward[v] = b.visited(v);
+    b.reset();
+    b.run(p, true);
+    for (vertices_size_type v = 0; v != n; ++v)
+        if (forward[v] && b.visited(v)) {
+            component[v] = p;
+            done[v]      = 1;}
+
+    // iterative Tarjan over the vertices left
+    std::vector<vertices_size_type> index(n, none);
+    std::vector<vertices_size_type> low(n, 0);
+    std::vector<char>               on_stack(n, 0);
+    std::vector<vertex_descriptor>  stack;
+    std::vector< std::pair<vertex_descriptor, const vertex_descriptor*> > call;
+    vertices_size_type              k = 0;
+    for (vertices_size_type r = 0; r != n; ++r) {
+        if (done[r] || (index[r] != none))
+            continue;
+        index[r] = low[r] = k++;
+        stack.push_back(r);
+        on_stack[r] = 1;
+        call.push_back(std::make_pair(r, b.out_edges(r).first));
+        while (!call.empty()) {
+            const vertex_descriptor   v = call.back().first;
+            const vertex_descriptor*& i = call.back().second;
+            if (i != b.out_edges(v).second) {
+                const vertex_descriptor w = *i++;
+                if (done[w])
+                    continue;
+                if (index[w] == none) {
+                    index[w] = low[w] = k++;
+                    stack.push_back(w);
+                    on_stack[w] = 1;
+                    call.push_back(std::make_pair(w, b.out_edges(w).first));}
+                else if (on_stack[w])
+                    low[v] = std::min(low[v], index[w]);
+                continue;}
+            if (low[v] == index[v]) {
+                vertex_descriptor w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w]  = 0;
+                    component[w] = v;
+                    done[w]      = 1;}
+                while (w != v);}
+            call.pop_back();
+            if (!call.empty())
+                low[call.back().first] = std::min(low[call.back().first], low[v]);}}
+    return relabel_labels(component);}
+
+// ----------------
+// topological_sort
+// ----------------
+
+/**
+ * @param g is a graph by reference
+ * @param x is an output iterator
+ * write the vertices of g to x so that every edge goes from an earlier vertex to a later one,
+ * vertices are written in the order they become ready, those ready at the start by index;
+ * iterative (Kahn), so deep graphs cannot overflow the stack
+ * return true if g is acyclic; otherwise only the vertices not on or after a cycle are written
+ */
+template <typename G, typename OI>
+bool topological_sort (const G& g, OI x) {
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::size_t n = num_vertices(g);
+    std::vector<typename G::edges_size_type> in(n, 0);
+    for (std::size_t v = 0; v != n; ++v) {
+        std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(v, g), g);
+        for (; p.first != p.second; ++p.first)
+            ++in[*p.first];}
+    std::vector<vertex_descriptor> q;
+    q.reserve(n);
+    for (std::size_t v = 0; v != n; ++v)
+        if (in[v] == 0)
+            q.push_back(v);
+    for (std::size_t i = 0; i != q.size(); ++i) {
+        const vertex_descriptor u = q[i];
+        *x++ = u;
+        std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+        for (; p.first != p.second; ++p.first)
+            if (--in[*p.first] == 0)
+                q.push_back(*p.first);}
+    return q.size() == n;}
+
+// ---------
+// has_cycle
+// ---------
+
+/**
+ * @param g is a graph by reference
+ * return true if g has a directed cycle, including a self loop
+ */
+template <typename G>
+bool has_cycle (const G& g) {
+    std::vector<typename G::vertex_descriptor> x;
+    return !topological_sort(g, std::back_inserter(x));}
+
+// --------
+// GraphDAG
+// --------
+
+/**
+ * a BasicGraph that stays acyclic: add_edge refuses any edge that would close a cycle
+ * keeps a topological order up to date as edges arrive (Pearce and Kelly); an edge that already agrees
+ * with the order costs a lookup, and one that does not searches and reorders only the vertices whose
+ * positions lie between its endpoints, instead of the whole graph
+ * V and A are the vertex index type and allocator of the BasicGraph underneath
+ */
+template <typename V = int, typename A = std::allocator<V> >
+class BasicGraphDAG {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef BasicGraph<V, A> graph_type;
+
+        typedef typename graph_type::vertex_descriptor  vertex_descriptor;
+        typedef typename graph_type::edge_descriptor    edge_descriptor;
+
+        typedef typename graph_type::vertex_iterator    vertex_iterator;
+        typedef typename graph_type::edge_iterator      edge_iterator;
+        typedef typename graph_type::adjacency_iterator adjacency_iterator;
+
+        typedef typename graph_type::vertices_size_type vertices_size_type;
+        typedef typename graph_type::edges_size_type    edges_size_type;
+
+    public:
+        // --------
+        // add_edge
+        // --------
+
+        /**
+         * @param u is a vertex_descriptor by value
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphDAG by reference
+         * return pair<edge_descriptor, bool> bool will be false if the edge was already in g or would make a cycle;
+         * edge(u, v, g) tells the two apart
+         */
+        friend std::pair<edge_descriptor, bool> add_edge (vertex_descriptor u, vertex_descriptor v, BasicGraphDAG& g) {
+            edge_descriptor ed = std::make_pair(u, v);
+            if (u == v)
+                return std::make_pair(ed, false);
+            while (num_vertices(g) <= static_cast<vertices_size_type>(std::max(u, v)))
+                add_vertex(g);
+            if (edge(u, v, g._g).second)
+                return std::make_pair(ed, false);
+            if ((g._ord[v] < g._ord[u]) && !g.reorder(u, v))
+                return std::make_pair(ed, false);
+            add_edge(u, v, g._g);
+            g._in[v].push_back(u);
+            assert(g._ord[u] < g._ord[v]);
+            return std::make_pair(ed, true);}
+
+        // ----------
+        // add_vertex
+        // ----------
+
+        /**
+         * @param g is a GraphDAG by reference
+         * add a vertex at the end of the topological order
+         * return added vertex value
+         */
+        friend vertex_descriptor add_vertex (BasicGraphDAG& g) {
+            const vertex_descriptor v = add_vertex(g._g);
+            g._ord.push_back(v);
+            g._at.push_back(v);
+            g._in.push_back(std::vector<vertex_descriptor>());
+            g._mark.push_back(0);
+            return v;}
+
+        // -----------------
+        // adjacent_vertices
+        // -----------------
+
+        /**
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphDAG by reference
+         * return a pair of iterators over the sorted targets of v in g
+         */
+        friend std::pair<adjacency_iterator, adjacency_iterator> adjacent_vertices (vertex_descriptor v, const BasicGraphDAG& g) {
+            return adjacent_vertices(v, g._g);}
+
+        // ----
+        // edge
+        // ----
+
+        /**
+         * @param u is a vertex_descriptor by value
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphDAG by reference
+         * return pair<edge_descriptor, bool> bool will be true if edge in g
+         */
+        friend std::pair<edge_descriptor, bool> edge (vertex_descriptor u, vertex_descriptor v, const BasicGraphDAG& g) {
+            return edge(u, v, g._g);}
+
+        // -----
+        // edges
+        // -----
+
+        /**
+         * @param g is a GraphDAG by reference
+         * return pair of begin and end iterators over edges in g
+         */
+        friend std::pair<edge_iterator, edge_iterator> edges (const BasicGraphDAG& g) {
+            return edges(g._g);}
+
+        // ---------
+        // num_edges
+        // ---------
+
+        /**
+         * @param g is a GraphDAG by reference
+         * return number of edges in g
+         */
+        friend edges_size_type num_edges (const BasicGraphDAG& g) {
+            return num_edges(g._g);}
+
+        // ------------
+        // num_vertices
+        // ------------
+
+        /**
+         * @param g is a GraphDAG by reference
+         * return number of vertices in g
+         */
+        friend vertices_size_type num_vertices (const BasicGraphDAG& g) {
+            return num_vertices(g._g);}
+
+        // ------
+        // source
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * @param g is a GraphDAG by reference
+         * return vertex_descriptor of source
+         */
+        friend vertex_descriptor source (edge_descriptor ed, const BasicGraphDAG&) {
+            return ed.first;}
+
+        // ------
+        // target
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * @param g is a GraphDAG by reference
+         * return vertex_descriptor of target
+         */
+        friend vertex_descriptor target (edge_descriptor ed, const BasicGraphDAG&) {
+            return ed.second;}
+
+        // ------
+        // vertex
+        // ------
+
+        /**
+         * @param vs is a vertices_size_type by value
+         * @param g is a GraphDAG by reference
+         * return vertex_descriptor of vertex
+         */
+        friend vertex_descriptor vertex (vertices_size_type vs, const BasicGraphDAG&) {
+            return vs;}
+
+        // --------
+        // vertices
+        // --------
+
+        /**
+         * @param g is a GraphDAG by reference
+         * return begin and end iterators over the vertices of g
+         */
+        friend std::pair<vertex_iterator, vertex_iterator> vertices (const BasicGraphDAG& g) {
+            return vertices(g._g);}
+
+        // -----------------
+        // topological_order
+        // -----------------
+
+        /**
+         * @param g is a GraphDAG by reference
+         * return the vertices of g in an order in which every edge goes forward
+         */
+        friend const std::vector<vertex_descriptor>& topological_order (const BasicGraphDAG& g) {
+            return g._at;}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        graph_type                                   _g;
+        std::vector<vertex_descriptor>               _ord;  // _ord[v] is the position of v in the order
+        std::vector<vertex_descriptor>               _at;   // _at[i] is the vertex at position i
+        std::vector< std::vector<vertex_descriptor> > _in;   // sources of the edges into each vertex
+        std::vector<char>                            _mark; // scratch for reorder, all 0 between calls
+
+        // -------
+        // reorder
+        // -------
+
+        /**
+         * @param u is the source of a new edge
+         * @param v is its target, positioned before u
+         * search forward from v and backward from u, both bounded by the positions of u and v,
+         * and move the vertices reaching u before those reachable from v
+         * return false, changing nothing, if v reaches u
+         */
+        bool reorder (vertex_descriptor u, vertex_descriptor v) {
+            const vertex_descriptor lb = _ord[v];
+            const vertex_descriptor ub = _ord[u];
+            std::vector<vertex_descriptor> forward;
+            std::vector<vertex_descriptor> backward;
+            std::vector<vertex_descriptor> stack(1, v);
+            _mark[v] = 1;
+            bool cycle = false;
+            while (!stack.empty() && !cycle) {
+                const vertex_descriptor x = stack.back();
+                stack.pop_back();
+                forward.push_back(x);
+                std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(x, _g);
+                for (; p.first != p.second; ++p.first) {
+                    const vertex_descriptor w = *p.first;
+                    if (w == u) {
+                        cycle = true;
+                        break;}
+                    if (!_mark[w] && (_ord[w] < ub)) {
+                        _mark[w] = 1;
+                        stack.push_back(w);}}}
+            if (cycle) {
+                for (std::size_t i = 0; i != forward.size(); ++i)
+                    _mark[forward[i]] = 0;
+                for (std::size_t i = 0; i != stack.size(); ++i)
+                    _mark[stack[i]] = 0;
+                return false;}
+
+            stack.push_back(u);
+            _mark[u] = 1;
+            while (!stack.empty()) {
+                const vertex_descriptor x = stack.back();
+                stack.pop_back();
+                backward.push_back(x);
+                for (std::size_t i = 0; i != _in[x].size(); ++i) {
+                    const vertex_descriptor w = _in[x][i];
+                    if (!_mark[w] && (lb < _ord[w])) {
+                        _mark[w] = 1;
+                        stack.push_back(w);}}}
+
+            // the affected vertices keep their set of positions; the backward ones take the lowest
+            const ByOrder by_order = {&_ord};
+            std::sort(forward.begin(),  forward.end(),  by_order);
+            std::sort(backward.begin(), backward.end(), by_order);
+            std::vector<vertex_descriptor> x(backward);
+            x.insert(x.end(), forward.begin(), forward.end());
+            std::vector<vertex_descriptor> positions;
+            positions.reserve(x.size());
+            for (std::size_t i = 0; i != x.size(); ++i) {
+                positions.push_back(_ord[x[i]]);
+                _mark[x[i]] = 0;}
+            std::sort(positions.begin(), positions.end());
+            for (std::size_t i = 0; i != x.size(); ++i) {
+                _ord[x[i]]       = positions[i];
+                _at[positions[i]] = x[i];}
+            return true;}
+
+        struct ByOrder {
+            const std::vector<vertex_descriptor>* ord;
+
+            bool operator () (vertex_descriptor lhs, vertex_descriptor rhs) const {
+                return (*ord)[lhs] < (*ord)[rhs];}};
+
+        // -----
+        // valid
+        // -----
+
+        /**
+         * _ord and _at are inverse permutations
+         */
+        bool valid () const {
+            for (std::size_t i = 0; i != _at.size(); ++i)
+                if (_ord[_at[i]] != static_cast<vertex_descriptor>(i))
+                    return false;
+            return (_at.size() == num_vertices(_g)) && (_in.size() == _at.size());}
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * empty graph, in which every order is topological
+         */
+        BasicGraphDAG () {
+            assert(valid());}
+
+        // Default copy, destructor, and copy assignment
+    };
+
+typedef BasicGraphDAG<> GraphDAG;
+
+// ---------------
+// GraphConcurrent
+// ---------------
+
+template <typename V>
+class BasicGraphSnapshot;
+
+/**
+ * a graph that many threads can add edges to at once while others read it through GraphSnapshots
+ * writers lock one of a fixed set of shards, chosen by source vertex, and write nothing else that is shared:
+ * each shard counts its own edges, and a writer only reads the global clock; readers take no locks at all
+ * every adjacency list is a chain of immutable versions; a version is a few sorted runs of targets, the
+ * older runs more than twice the size of the newer, and a short sorted tail that it copies from the version
+ * before; add_edge merges its targets into the tail, and only a full tail becomes a new run, merged with
+ * the small runs at the end, so an edge costs O(log deg(u)) amortized and one allocation, and the whole list is never copied
+ * the clock is advanced only by snapshots; a version is stamped with the clock as it stood once the version was
+ * published, by its writer before it unlocks or by the first reader that finds it unstamped, whichever comes first
+ * a snapshot advances the clock, keeps the value it advanced from, and for each vertex takes the newest version
+ * stamped at or before it; a version published after the snapshot advanced the clock is stamped after it
+ * old versions and runs are freed once no snapshot can reach them (epoch-based reclamation)
+ * V is the vertex index type; vertices are numbered below max_vertices, 2^32 - 1, whatever its size,
+ * and add_edge and add_edges refuse an edge with an end at or past it
+ */
+template <typename V = int>
+class BasicGraphConcurrent {
+    friend class BasicGraphSnapshot<V>;
+
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef V vertex_descriptor;
+        typedef std::pair<vertex_descriptor, vertex_descriptor> edge_descriptor;
+
+        typedef std::size_t vertices_size_type;
+        typedef std::size_t edges_size_type;
+
+        // ---------
+        // constants
+        // ---------
+
+        static const uint64_t max_vertices = (uint64_t(1) << 32) - 1; // the heads of segments 0 to 31
+
+    private:
+        typedef std::pair<const vertex_descriptor*, const vertex_descriptor*> range_type;
+
+        // -------
+        // Version
+        // -------
+
+        /**
+         * the targets of one vertex as of one stamp, as sorted, disjoint runs and a sorted tail disjoint from them;
+         * the runs follow the header, and the tail follows the runs
+         * runs are shared with the versions before and after, and belong to the last version that has them;
+         * the tail belongs to the version alone
+         */
+        struct Version {
+            const Version*                                   prev;
+            mutable std::atomic<uint64_t>                    stamp;  // pending until fixed
+            mutable std::atomic<const vertex_descriptor*>    merged; // the runs and tail merged into one, once a reader needed it
+            uint32_t                                         size;   // targets in all runs and the tail, fewer than the vertices
+            uint8_t                                          n_runs;
+            uint8_t                                          n_tail;
+            mutable uint8_t                                  kept;   // runs the next version still has
+
+            const range_type* begin () const {
+                return reinterpret_cast<const range_type*>(this + 1);}
+
+            range_type* begin () {
+                return reinterpret_cast<range_type*>(this + 1);}
+
+            const range_type* end () const {
+                return begin() + n_runs;}
+
+            const vertex_descriptor* tail () const {
+                return reinterpret_cast<const vertex_descriptor*>(end());}
+
+            vertex_descriptor* tail () {
+                return reinterpret_cast<vertex_descriptor*>(begin() + n_runs);}};
+
+        // -----
+        // Shard
+        // -----
+
+        struct Shard {
+            std::mutex                                  lock;
+            std::vector<std::pair<uint64_t, Version*> > retired; // versions replaced at a stamp, in stamp order
+            std::atomic<edges_size_type>                m;       // edges added through this shard, written under lock
+            char                                        pad[64];};
+
+        typedef std::atomic<const Version*> head_type;
+
+        static const std::size_t n_segments = 32;
+        static const std::size_t max_runs   = 64;  // run lengths more than double, so deg(u) < 2^32 needs fewer
+        static const std::size_t max_tail   = 16;
+        static const uint64_t    free_slot  = ~uint64_t(0);
+        static const uint64_t    pending    = ~uint64_t(0);
+
+    public:
+        // --------
+        // add_edge
+        // --------
+
+        /**
+         * @param u is a vertex_descriptor by value
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphConcurrent by reference
+         * return pair<edge_descriptor, bool> bool will be true if edge successfully added to graph g,
+         * and false if it was already in g or an end is not below max_vertices
+         * safe to call from many threads at once; O(log deg(u)) amortized, and no allocation but the new version
+         */
+        friend std::pair<edge_descriptor, bool> add_edge (vertex_descriptor u, vertex_descriptor v, BasicGraphConcurrent& g) {
+            edge_descriptor ed = std::make_pair(u, v);
+            assert((u >= 0) && (v >= 0));
+            if (static_cast<uint64_t>(std::max(u, v)) >= max_vertices)
+                return std::make_pair(ed, false);
+            g.grow(std::max(u, v));
+            const bool b = g.insert(u, &v, &v + 1) != 0;
+            return std::make_pair(ed, b);}
+
+        // ---------
+        // add_edges
+        // ---------
+
+        /**
+         * @param b is an input iterator to the first edge_descriptor
+         * @param e is an input iterator past the last edge_descriptor
+         * @param g is a GraphConcurrent by reference
+         * add every edge in [b, e) to g, one new version for each source in the batch,
+         * skipping any with an end not below max_vertices
+         * safe to call from many threads at once
+         * return the number of edges added
+         */
+        template <typename II>
+        friend edges_size_type add_edges (II b, II e, BasicGraphConcurrent& g) {
+            std::vector<edge_descriptor> a;
+            for (; b != e; ++b) {
+                const edge_descriptor x = *b;
+                assert((x.first >= 0) && (x.second >= 0));
+                if (static_cast<uint64_t>(std::max(x.first, x.second)) < max_vertices)
+                    a.push_back(x);}
+            if (a.empty())
+                return 0;
+            vertex_descriptor m = 0;
+            for (std::size_t i = 0; i != a.size(); ++i)
+                m = std::max(m, std::max(a[i].first, a[i].second));
+            g.grow(m);
+            std::sort(a.begin(), a.end());
+            a.erase(std::unique(a.begin(), a.end()), a.end());
+            std::vector<vertex_descriptor> x;
+            edges_size_type                s = 0;
+            for (std::size_t i = 0; i != a.size();) {
+                const vertex_descriptor u = a[i].first;
+                x.clear();
+                for (; (i != a.size()) && (a[i].first == u); ++i)
+                    x.push_back(a[i].second);
+                s += g.insert(u, x.data(), x.data() + x.size());}
+            return s;}
+
+        // ---------
+        // num_edges
+        // ---------
+
+        /**
+         * @param g is a GraphConcurrent by reference
+         * return number of edges added to g so far, summed over the shards; a snapshot may not see the latest of them yet
+         */
+        friend edges_size_type num_edges (const BasicGraphConcurrent& g) {
+            edges_size_type m = 0;
+            for (std::size_t i = 0; i != g._shards.size(); ++i)
+                m += g._shards[i].m.load(std::memory_order_relaxed);
+            return m;}
+
+        // ------------
+        // num_vertices
+        // ------------
+
+        /**
+         * @param g is a GraphConcurrent by reference
+         * return number of vertices in g so far
+         */
+        friend vertices_size_type num_vertices (const BasicGraphConcurrent& g) {
+            return g._n.load();}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        std::atomic<head_type*>                     _segments[n_segments]; // segment k holds the heads of vertices 2^k - 1 to 2^(k+1) - 2
+        std::atomic<vertices_size_type>             _n;
+        std::vector<Shard>                          _shards;
+        mutable std::atomic<uint64_t>               _clock;   // advanced by each snapshot, only read by writers
+        mutable std::atomic<std::size_t>            _open;    // snapshots open, counted before they announce
+        mutable std::vector<std::atomic<uint64_t> > _readers; // the oldest stamp each snapshot may still read, or free_slot
+
+        // ----
+        // head
+        // ----
+
+        static std::size_t segment (vertex_descriptor v) {
+            return 63 - __builtin_clzll(static_cast<uint64_t>(v) + 1);}
+
+        head_type& head (vertex_descriptor v) const {
+            const std::size_t k = segment(v);
+            return _segments[k].load()[static_cast<uint64_t>(v) + 1 - (uint64_t(1) << k)];}
+
+        // ----
+        // grow
+        // ----
+
+        /**
+         * make room for the vertices up to v, then count them; v is below max_vertices, as add_edge and add_edges check
+         */
+        void grow (vertex_descriptor v) {
+            // the segments of the vertices counted were made before they were counted
+            if (static_cast<vertices_size_type>(v) < _n.load())
+                return;
+            const std::size_t k = segment(v);
+            assert(k < n_segments);
+            for (std::size_t i = 0; i <= k; ++i)
+                if (!_segments[i].load()) {
+                    const std::size_t n = std::size_t(1) << i;
+                    head_type*        p = new head_type[n];
+                    for (std::size_t j = 0; j != n; ++j)
+                        p[j].store(0, std::memory_order_relaxed);
+                    head_type* expected = 0;
+                    if (!_segments[i].compare_exchange_strong(expected, p))
+                        delete [] p;}
+            vertices_size_type n = _n.load();
+            while ((n <= static_cast<vertices_size_type>(v)) && !_n.compare_exchange_weak(n, v + 1))
+                {}}
+
+        // ------
+        // insert
+        // ------
+
+        /**
+         * merge the sorted, distinct targets [b, e) into the adjacency of u: the new ones join the tail, and a tail
+         * that would pass max_tail becomes a new run instead, after which the last two runs are merged while the
+         * older is no more than twice the size of the newer
+         * return the number of them that were new
+         */
+        std::size_t insert (vertex_descriptor u, const vertex_descriptor* b, const vertex_descriptor* e) {
+            head_type& h     = head(u);
+            Shard&     shard = _shards[u & (_shards.size() - 1)];
+            std::lock_guard<std::mutex> l(shard.lock);
+            const Version* old = h.load(std::memory_order_relaxed);
+
+            // the new targets, on the stack unless a batch brings many
+            vertex_descriptor              small[max_tail];
+            std::vector<vertex_descriptor> large;
+            vertex_descriptor*             x = small;
+            if (static_cast<std::size_t>(e - b) > max_tail) {
+                large.resize(e - b);
+                x = large.data();}
+            std::size_t n = 0;
+            for (const vertex_descriptor* p = b; p != e; ++p)
+                if (!contains(old, *p))
+                    x[n++] = *p;
+            if (n == 0)
+                return 0;
+
+            // runs made by this call are nobody else's, so a merge frees them at once
+            const vertex_descriptor* ob     = old ? old->tail()   : 0;
+            const std::size_t        on     = old ? old->n_tail   : 0;
+            range_type               runs[max_runs];
+            std::size_t              n_runs = old ? old->n_runs   : 0;
+            std::size_t              kept   = n_runs;
+            std::size_t              n_tail = on + n;
+            if (old)
+                std::copy(old->begin(), old->end(), runs);
+            if (n_tail > max_tail) {
+                runs[n_runs++] = make_run(ob, ob + on, x, x + n);
+                n_tail = 0;
+                while ((n_runs >= 2) && (length(runs[n_runs - 2]) <= 2 * length(runs[n_runs - 1]))) {
+                    const range_type r = runs[n_runs - 1];
+                    const range_type q = runs[n_runs - 2];
+                    --n_runs;
+                    runs[n_runs - 1] = make_run(q.first, q.second, r.first, r.second);
+                    if (n_runs <= kept)
+                        kept = n_runs - 1;
+                    else
+                        ::operator delete(const_cast<vertex_descriptor*>(q.first));
+                    ::operator delete(const_cast<vertex_descriptor*>(r.first));}}
+            assert(n_runs <= max_runs);
+
+            Version* w = static_cast<Version*>(::operator new(sizeof(Version) + (n_runs * sizeof(range_type)) + (n_tail * sizeof(vertex_descriptor))));
+            w->prev = old;
+            w->stamp.store(pending, std::memory_order_relaxed);
+            w->merged.store(0, std::memory_order_relaxed);
+            w->size   = static_cast<uint32_t>((old ? old->size : 0) + n);
+            w->n_runs = static_cast<uint8_t>(n_runs);
+            w->n_tail = static_cast<uint8_t>(n_tail);
+            w->kept   = static_cast<uint8_t>(n_runs);
+            std::copy(runs, runs + n_runs, w->begin());
+            if (n_tail != 0)
+                std::merge(ob, ob + on, x, x + n, w->tail());
+            // sequentially consistent, so a snapshot that advances the clock before this reads it either sees w
+            // or leaves it to be stamped after its own stamp
+            h.store(w);
+            // fixed before the shard is unlocked, so stamps rise along every chain of versions
+            const uint64_t s = stamp(w);
+            shard.m.store(shard.m.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+
+            // with no snapshot open, one that opens from now on advances the clock after it was read for s, so sees w;
+            // old can go now, while it is still in cache
+            if (old) {
+                old->kept = static_cast<uint8_t>(kept);
+                if (_open.load() == 0) {
+                    release(old, kept);
+                    if (!shard.retired.empty())
+                        collect(shard);}
+                else {
+                    shard.retired.push_back(std::make_pair(s, const_cast<Version*>(old)));
+                    if (shard.retired.size() >= 64)
+                        collect(shard);}}
+            return n;}
+
+        // --------
+        // make_run
+        // --------
+
+        /**
+         * return a new run holding the union of the sorted, disjoint ranges [b1, e1) and [b2, e2)
+         */
+        static range_type make_run (const vertex_descriptor* b1, const vertex_descriptor* e1, const vertex_descriptor* b2, const vertex_descriptor* e2) {
+            vertex_descriptor* p = static_cast<vertex_descriptor*>(::operator new(((e1 - b1) + (e2 - b2)) * sizeof(vertex_descriptor)));
+            return range_type(p, std::merge(b1, e1, b2, e2, p));}
+
+        static std::size_t length (const range_type& r) {
+            return r.second - r.first;}
+
+        // --------
+        // contains
+        // --------
+
+        static bool contains (const Version* p, vertex_descriptor v) {
+            if (!p)
+                return false;
+            if (std::binary_search(p->tail(), p->tail() + p->n_tail, v))
+                return true;
+            for (const range_type* r = p->begin(); r != p->end(); ++r)
+                if (std::binary_search(r->first, r->second, v))
+                    return true;
+            return false;}
+
+        // -----
+        // stamp
+        // -----
+
+        /**
+         * return the stamp of p, first stamping it with the clock if no one has yet
+         * every thread that reads the stamp of p reads the same one; the clock is read after p was published,
+         * so a snapshot whose stamp is at least it advanced the clock after p was published, and sees p
+         * a reader only finds p unstamped after it advanced the clock for its own snapshot, so p is stamped after it
+         * only a load of the clock, so writers to different shards share no written cache line
+         */
+        uint64_t stamp (const Version* p) const {
+            uint64_t s = p->stamp.load(std::memory_order_acquire);
+            if (s == pending) {
+                const uint64_t t = _clock.load();
+                if (p->stamp.compare_exchange_strong(s, t))
+                    s = t;}
+            return s;}
+
+        // -------
+        // targets
+        // -------
+
+        /**
+         * return the targets of p as one sorted range: its tail or its only run, if that is all it has, or else its
+         * runs and tail merged once, by the first reader that needed them, and kept with p for the others
+         */
+        range_type targets (const Version* p) const {
+            if (p->n_runs == 0)
+                return range_type(p->tail(), p->tail() + p->n_tail);
+            if ((p->n_runs == 1) && (p->n_tail == 0))
+                return *p->begin();
+            const vertex_descriptor* m = p->merged.load(std::memory_order_acquire);
+            if (!m) {
+                vertex_descriptor* x = static_cast<vertex_descriptor*>(::operator new(p->size * sizeof(vertex_descriptor)));
+                vertex_descriptor* e = x;
+                vertex_descriptor* bounds[max_runs + 1];
+                std::size_t        k = 0;
+                for (const range_type* r = p->begin(); r != p->end(); ++r) {
+                    bounds[k++] = e;
+                    e = std::copy(r->first, r->second, e);}
+                bounds[k++] = e;
+                e = std::copy(p->tail(), p->tail() + p->n_tail, e);
+                // newest runs are smallest, and the tail smaller still, so merging from the back touches each target
+                // O(1) times amortized
+                for (std::size_t i = k - 1; i-- != 0;)
+                    std::inplace_merge(bounds[i], bounds[i + 1], e);
+                if (p->merged.compare_exchange_strong(m, x, std::memory_order_acq_rel))
+                    m = x;
+                else
+                    ::operator delete(x);}
+            return range_type(m, m + p->size);}
+
+        // -------
+        // release
+        // -------
+
+        /**
+         * free p with its tail, its merged targets, and the runs from first on, which no later version has
+         */
+        static void release (const Version* p, std::size_t first) {
+            for (const range_type* r = p->begin() + first; r != p->end(); ++r)
+                ::operator delete(const_cast<vertex_descriptor*>(r->first));
+            ::operator delete(const_cast<vertex_descriptor*>(p->merged.load()));
+            ::operator delete(const_cast<Version*>(p));}
+
+        // ------
+        // oldest
+        // ------
+
+        /**
+         * return the oldest stamp that a snapshot may still read
+         * the clock is read before the readers, and a snapshot announces itself before it advances the clock,
+         * so a snapshot that is missed here takes a stamp at least as new as the one returned
+         */
+        uint64_t oldest () const {
+            uint64_t s = _clock.load();
+            for (std::size_t i = 0; i != _readers.size(); ++i)
+                s = std::min(s, _readers[i].load());
+            return s;}
+
+        // -------
+        // collect
+        // -------
+
+        /**
+         * free the retired versions of a shard that no snapshot can reach: a version replaced at stamp s is only
+         * reachable from a snapshot older than s
+         */
+        void collect (Shard& shard) {
+            const uint64_t s = oldest();
+            std::size_t    i = 0;
+            for (; (i != shard.retired.size()) && (shard.retired[i].first <= s); ++i)
+                release(shard.retired[i].second, shard.retired[i].second->kept);
+            shard.retired.erase(shard.retired.begin(), shard.retired.begin() + i);}
+
+        // ----------
+        // power_of_2
+        // ----------
+
+        /**
+         * return the smallest power of two at least n, 1 for 0
+         */
+        static std::size_t power_of_2 (std::size_t n) {
+            std::size_t p = 1;
+            while (p < n)
+                p <<= 1;
+            return p;}
+
+        // -----
+        // valid
+        // -----
+
+        bool valid () const {
+            return (_shards.size() != 0) && !(_shards.size() & (_shards.size() - 1)) && (_readers.size() != 0);}
+
+        BasicGraphConcurrent             (const BasicGraphConcurrent&);
+        BasicGraphConcurrent& operator = (const BasicGraphConcurrent&);
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * @param n_shards    is the number of writer locks, rounded up to a power of two
+         * @param max_readers is the number of snapshots that may be open at once; a further one waits for a free slot
+         */
+        explicit BasicGraphConcurrent (std::size_t n_shards = 256, std::size_t max_readers = 64) :
+                _n       (0),
+                _shards  (power_of_2(n_shards)),
+                _clock   (0),
+                _open    (0),
+                _readers (std::max<std::size_t>(max_readers, 1)) {
+            for (std::size_t i = 0; i != n_segments; ++i)
+                _segments[i].store(0);
+            for (std::size_t i = 0; i != _shards.size(); ++i)
+                _shards[i].m.store(0);
+            for (std::size_t i = 0; i != _readers.size(); ++i)
+                _readers[i].store(free_slot);
+            assert(valid());}
+
+        /**
+         * no snapshot of g may outlive it
+         */
+        ~BasicGraphConcurrent () {
+            for (std::size_t k = 0; k != n_segments; ++k) {
+                head_type* p = _segments[k].load();
+                if (!p)
+                    continue;
+                for (std::size_t j = 0; j != (std::size_t(1) << k); ++j)
+                    if (p[j].load())
+                        release(p[j].load(), 0);
+                delete [] p;}
+            for (std::size_t i = 0; i != _shards.size(); ++i)
+                for (std::size_t j = 0; j != _shards[i].retired.size(); ++j)
+                    release(_shards[i].retired[j].second, _shards[i].retired[j].second->kept);}
+
+        // ------
+        // shards
+        // ------
+
+        /**
+         * return the number of writer locks
+         */
+        std::size_t shards () const {
+            return _shards.size();}};
+
+typedef BasicGraphConcurrent<> GraphConcurrent;
+
+// -------------
+// GraphSnapshot
+// -------------
+
+/**
+ * a read-only view of a GraphConcurrent as of one stamp: every edge committed by then, and none after,
+ * however long the snapshot is kept and however many edges are added meanwhile
+ * opening one takes a reader slot and advances the clock, the only write writers ever see; reading never waits on a writer
+ * models the same read interface as Graph, so it can be passed to GraphCSR, GraphBFS, topological_sort, etc.
+ * a snapshot may be read from several threads at once
+ * V is the vertex index type of the BasicGraphConcurrent it views
+ */
+template <typename V = int>
+class BasicGraphSnapshot {
+    public:
+        // --------
+        // typedefs
+        // --------
+
+        typedef BasicGraphConcurrent<V> graph_type;
+
+        typedef typename graph_type::vertex_descriptor  vertex_descriptor;
+        typedef typename graph_type::edge_descriptor    edge_descriptor;
+
+        typedef GraphVertexIterator<vertex_descriptor> vertex_iterator;
+        typedef const vertex_descriptor*               adjacency_iterator;
+
+        typedef typename graph_type::vertices_size_type vertices_size_type;
+        typedef typename graph_type::edges_size_type    edges_size_type;
+
+    private:
+        typedef typename graph_type::Version version_type;
+
+    public:
+
+        // -------------
+        // edge_iterator
+        // -------------
+
+        class edge_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef edge_descriptor           value_type;
+                typedef std::ptrdiff_t            difference_type;
+                typedef const edge_descriptor*    pointer;
+                typedef edge_descriptor           reference;
+
+            private:
+                const BasicGraphSnapshot* _s;
+                vertex_descriptor         _u;
+                const vertex_descriptor*  _b;
+                const vertex_descriptor*  _e;
+
+                void load () {
+                    std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(_u, *_s);
+                    _b = p.first;
+                    _e = p.second;}
+
+                void skip () {
+                    while (_b == _e) {
+                        if (static_cast<vertices_size_type>(++_u) == _s->_n) {
+                            _b = _e = 0;
+                            return;}
+                        load();}}
+
+            public:
+                edge_iterator () :
+                        _s (0),
+                        _u (0),
+                        _b (0),
+                        _e (0)
+                    {}
+
+                edge_iterator (const BasicGraphSnapshot& s, vertex_descriptor u) :
+                        _s (&s),
+                        _u (u),
+                        _b (0),
+                        _e (0) {
+                    if (static_cast<vertices_size_type>(_u) != _s->_n) {
+                        load();
+                        skip();}}
+
+                friend bool operator == (const edge_iterator& lhs, const edge_iterator& rhs) {
+                    return (lhs._u == rhs._u) && (lhs._b == rhs._b);}
+
+                friend bool operator != (const edge_iterator& lhs, const edge_iterator& rhs) {
+                    return !(lhs == rhs);}
+
+                reference operator * () const {
+                    return std::make_pair(_u, *_b);}
+
+                edge_iterator& operator ++ () {
+                    ++_b;
+                    skip();
+                    return *this;}
+
+                edge_iterator operator ++ (int) {
+                    edge_iterator x = *this;
+                    ++*this;
+                    return x;}};
+
+    public:
+        // -----------------
+        // adjacent_vertices
+        // -----------------
+
+        /**
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphSnapshot by reference
+         * return a pair of pointers over the sorted targets of v as of the snapshot
+         */
+        friend std::pair<adjacency_iterator, adjacency_iterator> adjacent_vertices (vertex_descriptor v, const BasicGraphSnapshot& g) {
+            return g.adjacency(v);}
+
+        // ----
+        // edge
+        // ----
+
+        /**
+         * @param u is a vertex_descriptor by value
+         * @param v is a vertex_descriptor by value
+         * @param g is a GraphSnapshot by reference
+         * return pair<edge_descriptor, bool> bool will be true if edge in g
+         */
+        friend std::pair<edge_descriptor, bool> edge (vertex_descriptor u, vertex_descriptor v, const BasicGraphSnapshot& g) {
+            edge_descriptor ed = std::make_pair(u, v);
+            bool            b  = false;
+            if ((u >= 0) && (static_cast<vertices_size_type>(u) < g._n)) {
+                std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+                b = std::binary_search(p.first, p.second, v);}
+            return std::make_pair(ed, b);}
+
+        // -----
+        // edges
+        // -----
+
+        /**
+         * @param g is a GraphSnapshot by reference
+         * return pair of begin and end iterators over edges in g, ordered by (source, target)
+         */
+        friend std::pair<edge_iterator, edge_iterator> edges (const BasicGraphSnapshot& g) {
+            return std::make_pair(edge_iterator(g, 0), edge_iterator(g, g._n));}
+
+        // ---------
+        // num_edges
+        // ---------
+
+        /**
+         * @param g is a GraphSnapshot by reference
+         * return number of edges in g; counted on the first call, O(V), without merging any runs
+         */
+        friend edges_size_type num_edges (const BasicGraphSnapshot& g) {
+            edges_size_type m = g._m.load(std::memory_order_relaxed);
+            if (m == edges_size_type(-1)) {
+                m = 0;
+                for (vertices_size_type v = 0; v != g._n; ++v)
+                    m += g.degree(v);
+                g._m.store(m, std::memory_order_relaxed);}
+            return m;}
+
+        // ------------
+        // num_vertices
+        // ------------
+
+        /**
+         * @param g is a GraphSnapshot by reference
+         * return number of vertices in g; may count a vertex whose first edge the snapshot does not see
+         */
+        friend vertices_size_type num_vertices (const BasicGraphSnapshot& g) {
+            return g._n;}
+
+        // ------
+        // source
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * return vertex_descriptor of source
+         */
+        friend vertex_descriptor source (edge_descriptor ed, const BasicGraphSnapshot&) {
+            return ed.first;}
+
+        // ------
+        // target
+        // ------
+
+        /**
+         * @param ed is a edge_descriptor by value
+         * return vertex_descriptor of target
+         */
+        friend vertex_descriptor target (edge_descriptor ed, const BasicGraphSnapshot&) {
+            return ed.second;}
+
+        // ------
+        // vertex
+        // ------
+
+        /**
+         * @param vs is a vertices_size_type by value
+         * return vertex_descriptor of vertex
+         */
+        friend vertex_descriptor vertex (vertices_size_type vs, const BasicGraphSnapshot&) {
+            return vs;}
+
+        // --------
+        // vertices
+        // --------
+
+        /**
+         * @param g is a GraphSnapshot by reference
+         * return begin and end iterators over the vertices of g
+         */
+        friend std::pair<vertex_iterator, vertex_iterator> vertices (const BasicGraphSnapshot& g) {
+            return std::make_pair(vertex_iterator(0), vertex_iterator(g._n));}
+
+    private:
+        // ----
+        // data
+        // ----
+
+        const graph_type*                    _g;
+        std::atomic<uint64_t>*               _slot;
+        uint64_t                             _stamp;
+        vertices_size_type                   _n;
+        mutable std::atomic<edges_size_type> _m;
+
+        // -------
+        // version
+        // -------
+
+        /**
+         * walk back from the newest version of v to the newest one stamped at or before the snapshot
+         * the head is read sequentially consistent, after the clock was advanced, to pair with the writer's store
+         */
+        const version_type* version (vertex_descriptor v) const {
+            const version_type* p = _g->head(v).load();
+            while (p && (_g->stamp(p) > _stamp))
+                p = p->prev;
+            return p;}
+
+        edges_size_type degree (vertex_descriptor v) const {
+            const version_type* p = version(v);
+            return p ? p->size : 0;}
+
+        // ---------
+        // adjacency
+        // ---------
+
+        std::pair<adjacency_iterator, adjacency_iterator> adjacency (vertex_descriptor v) const {
+            const version_type* p = version(v);
+            if (!p)
+                return std::make_pair(adjacency_iterator(0), adjacency_iterator(0));
+            return _g->targets(p);}
+
+        BasicGraphSnapshot             (const BasicGraphSnapshot&);
+        BasicGraphSnapshot& operator = (const BasicGraphSnapshot&);
+
+    public:
+        // ------------
+        // constructors
+        // ------------
+
+        /**
+         * take a free reader slot, announce the clock, then advance it and keep the value it had;
+         * the announced stamp can only be older, which keeps everything the snapshot reads alive
+         */
+        explicit BasicGraphSnapshot (const graph_type& g) :
+                _g    (&g),
+                _slot (0),
+                _m    (-1) {
+            std::vector<std::atomic<uint64_t> >& r = g._readers;
+            g._open.fetch_add(1);
+            while (!_slot) {
+                for (std::size_t i = 0; !_slot && (i != r.size()); ++i) {
+                    uint64_t expected = graph_type::free_slot;
+                    if (r[i].compare_exchange_strong(expected, g._clock.load()))
+                        _slot = &r[i];}
+                if (!_slot)
+                    std::this_thread::yield();}
+            _stamp = g._clock.fetch_add(1);
+            _n     = g._n.load();}
+
+        BasicGraphSnapshot (BasicGraphSnapshot&& that) :
+                _g     (that._g),
+                _slot  (that._slot),
+                _stamp (that._stamp),
+                _n     (that._n),
+                _m     (that._m.load()) {
+            that._slot = 0;}
+
+        ~BasicGraphSnapshot () {
+            if (_slot) {
+                _slot->store(graph_type::free_slot);
+                _g->_open.fetch_sub(1);}}
+
+        /**
+         * return the stamp of the snapshot: it holds every edge added by a write stamped at or before it
+         */
+        uint64_t stamp () const {
+            return _stamp;}};
+
+typedef BasicGraphSnapshot<> GraphSnapshot;
+
+// ---------------
+// intersect_merge
+// ---------------
+
+/**
+ * @param a  is a sorted range without duplicates
+ * @param na is the size of a
+ * @param b  is a sorted range without duplicates
+ * @param nb is the size of b
+ * @param x  is where to write the common elements, in order, with room for min(na, nb); unused unless W
+ * return the number of elements common to a and b
+ * W is true to write to x as well as count; it is a template parameter so that the test is made at compile time
+ * each step stores a[i] to x[k] whether or not it matched, and advances k, i, and j by comparisons,
+ * so the merge is branch-free but for the loop itself
+ */
+template <typename T, bool W>
+inline std::size_t intersect_merge (const T* a, std::size_t na, const T* b, std::size_t nb, T* x) {
+    std::size_t i = 0;
+    std::size_t j = 0;
+    std::size_t k = 0;
+    while ((i != na) && (j != nb)) {
+        const T p = a[i];
+        const T q = b[j];
+        if (W)
+            x[k] = p;
+        k += (p == q);
+        i += (p <= q);
+        j += (q <= p);}
+    return k;}
+
+// ----------------
+// intersect_scalar
+// ----------------
+
+/**
+ * @param a  is a sorted range without duplicates
+ * @param na is the size of a
+ * @param b  is a sorted range without duplicates
+ * @param nb is the size of b
+ * @param x  is where to write the common elements, in order, or 0 to only count them
+ * return the number of elements common to a and b
+ * a branch-free merge, so it costs the same whether or not the branch predictor has seen these lists;
+ * the test for x is made once, not per step; x needs room for min(na, nb), since a step stores before it knows
+ */
+template <typename T>
+inline std::size_t intersect_scalar (const T* a, std::size_t na, const T* b, std::size_t nb, T* x) {
+    if (x)
+        return intersect_merge<T, true>(a, na, b, nb, x);
+    return intersect_merge<T, false>(a, na, b, nb, x);}
+
+// ----------------
+// intersect_gallop
+// ----------------
+
+/**
+ * as intersect_scalar, for when b is much longer than a: each element of a is found in b by an
+ * exponential search from where the last one was, O(na log(nb / na))
+ */
+template <typename T>
+inline std::size_t intersect_gallop (const T* a, std::size_t na, const T* b, std::size_t nb, T* x) {
+    std::size_t j = 0;
+    std::size_t k = 0;
+    for (std::size_t i = 0; (i != na) && (j != nb); ++i) {
+        std::size_t step = 1;
+        while (((j + step) < nb) && (b[j + step] < a[i]))
+            step *= 2;
+        j = std::lower_bound(b + j, b + std::min(j + step + 1, nb), a[i]) - b;
+        if ((j != nb) && (b[j] == a[i])) {
+            if (x)
+                x[k] = a[i];
+            ++k;}}
+    return k;}
+
+#ifdef GRAPH_SIMD
+
+// -------------
+// intersect_sse
+// -------------
+
+/**
+ * as intersect_scalar, for 32-bit elements: compares a block of 4 from a with every rotation of a block
+ * of 4 from b, then steps past whichever block ends lower (both, if they end alike)
+ */
+template <typename T>
+inline std::size_t intersect_sse (const T* a, std::size_t na, const T* b, std::size_t nb, T* x) {
+    static_assert(sizeof(T) == 4, "intersect_sse needs 32-bit elements");
+    std::size_t       i  = 0;
+    std::size_t       j  = 0;
+    std::size_t       k  = 0;
+    const std::size_t ia = na & ~std::size_t(3);
+    const std::size_t jb = nb & ~std::size_t(3);
+    while ((i < ia) && (j < jb)) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+        const __m128i m  = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(m));
+        if (!x)
+            k += __builtin_popcount(mask);
+        else
+            for (; mask; mask &= mask - 1)
+                x[k++] = a[i + __builtin_ctz(mask)];
+        const T p = a[i + 3];
+        const T q = b[j + 3];
+        i += (p <= q) * 4;
+        j += (q <= p) * 4;}
+    return k + intersect_scalar(a + i, na - i, b + j, nb - j, x ? (x + k) : x);}
+
+// --------------
+// intersect_avx2
+// --------------
+
+/**
+ * as intersect_sse, with blocks of 8; only call it when has_avx2()
+ */
+template <typename T>
+__attribute__ ((target ("avx2")))
+std::size_t intersect_avx2 (const T* a, std::size_t na, const T* b, std::size_t nb, T* x) {
+    static_assert(sizeof(T) == 4, "intersect_avx2 needs 32-bit elements");
+    std::size_t       i  = 0;
+    std::size_t       j  = 0;
+    std::size_t       k  = 0;
+    const std::size_t ia = na & ~std::size_t(7);
+    const std::size_t jb = nb & ~std::size_t(7);
+    while ((i < ia) && (j < jb)) {
+        // the rotations within each half of b, then of b with its halves swapped; none depends on another
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+        const __m256i vs = _mm256_permute2x128_si256(vb, vb, 1);
+        const __m256i m  = _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, vb),
+                                _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                                _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3))))),
+            _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, vs),
+                                _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm256_or_si256(_mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, _MM_SHUFFLE(1, 0, 3, 2))),
+                                _mm256_cmpeq_epi32(va, _mm256_shuffle_epi32(vs, _MM_SHUFFLE(2, 1, 0, 3))))));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(m));
+        if (!x)
+            k += __builtin_popcount(mask);
+        else
+            for (; mask; mask &= mask - 1)
+                x[k++] = a[i + __builtin_ctz(mask)];
+        const T p = a[i + 7];
+        const T q = b[j + 7];
+        i += (p <= q) * 8;
+        j += (q <= p) * 8;}
+    return k + intersect_sse(a + i, na - i, b + j, nb - j, x ? (x + k) : x);}
+
+// --------
+// has_avx2
+// --------
+
+/**
+ * return true if the running CPU has AVX2; asked once
+ */
+inline bool has_avx2 () {
+    static const bool b = __builtin_cpu_supports("avx2");
+    return b;}
+
+#endif // GRAPH_SIMD
+
+// ---------------
+// intersect_block
+// ---------------
+
+template <typename T>
+inline std::size_t intersect_block (const T* a, std::size_t na, const T* b, std::size_t nb, T* x, std::false_type) {
+    return intersect_scalar(a, na, b, nb, x);}
+
+/**
+ * a block compare only pays once the shorter range fills a few blocks: below 16 elements the plain merge wins,
+ * and below 32 the tail of the 8-wide AVX2 blocks costs more than it saves over SSE
+ */
+template <typename T>
+inline std::size_t intersect_block (const T* a, std::size_t na, const T* b, std::size_t nb, T* x, std::true_type) {
+#ifdef GRAPH_SIMD
+    if (na < 16)
+        return intersect_scalar(a, na, b, nb, x);
+    if ((na >= 32) && has_avx2())
+        return intersect_avx2(a, na, b, nb, x);
+    return intersect_sse(a, na, b, nb, x);
+#else
+    return intersect_scalar(a, na, b, nb, x);
+#endif
+    }
+
+// ---------
+// intersect
+// ---------
+
+/**
+ * @param a  is a sorted range without duplicates
+ * @param na is the size of a
+ * @param b  is a sorted range without duplicates
+ * @param nb is the size of b
+ * @param x  is where to write the common elements, in order, or 0 to only count them; room for min(na, nb)
+ * return the number of elements common to a and b
+ * gallops when one range is over 32 times the other, and otherwise merges by blocks of SSE or AVX2 vectors,
+ * chosen by the length of the shorter range, for 32-bit elements, or one element at a time for any other
+ */
+template <typename T>
+inline std::size_t intersect (const T* a, std::size_t na, const T* b, std::size_t nb, T* x = 0) {
+    if (na > nb)
+        return intersect(b, nb, a, na, x);
+    if (na == 0)
+        return 0;
+    if ((nb / na) >= 32)
+        return intersect_gallop(a, na, b, nb, x);
+    return intersect_block(a, na, b, nb, x, std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) == 4)>());}
+
+// -----------------
+// intersection_size
+// -----------------
+
+/**
+ * @param b1 is an iterator to the first element of a sorted range without duplicates
+ * @param e1 is an iterator past its last
+ * @param b2 is an iterator to the first element of a sorted range without duplicates
+ * @param e2 is an iterator past its last
+ * return the number of elements common to both; ranges of pointers go through intersect
+ */
+template <typename I1, typename I2>
+inline std::size_t intersection_size (I1 b1, I1 e1, I2 b2, I2 e2) {
+    std::size_t k = 0;
+    while ((b1 != e1) && (b2 != e2)) {
+        if (*b1 < *b2)
+            ++b1;
+        else if (*b2 < *b1)
+            ++b2;
+        else {
+            ++k;
+            ++b1;
+            ++b2;}}
+    return k;}
+
+template <typename T>
+inline std::size_t intersection_size (const T* b1, const T* e1, const T* b2, const T* e2) {
+    return intersect(b1, e1 - b1, b2, e2 - b2);}
+
+// ------------
+// intersection
+// ------------
+
+/**
+ * as intersection_size, writing the common elements to x
+ * return the end of the output
+ * ranges of pointers go through intersect; into a pointer it writes directly, so x needs room for the
+ * shorter range, and into any other output iterator through a buffer of that size
+ */
+template <typename I1, typename I2, typename OI>
+inline OI intersection (I1 b1, I1 e1, I2 b2, I2 e2, OI x) {
+    return std::set_intersection(b1, e1, b2, e2, x);}
+
+template <typename T, typename OI>
+inline OI intersection (const T* b1, const T* e1, const T* b2, const T* e2, OI x) {
+    std::vector<T> y(std::min(e1 - b1, e2 - b2));
+    y.resize(intersect(b1, e1 - b1, b2, e2 - b2, y.data()));
+    return std::copy(y.begin(), y.end(), x);}
+
+template <typename T>
+inline T* intersection (const T* b1, const T* e1, const T* b2, const T* e2, T* x) {
+    return x + intersect(b1, e1 - b1, b2, e2 - b2, x);}
+
+// --------------------
+// num_common_neighbors
+// --------------------
+
+/**
+ * @param u is a vertex_descriptor by value
+ * @param v is a vertex_descriptor by value
+ * @param g is a graph by reference
+ * return the number of vertices that both u and v have edges to
+ */
+template <typename G>
+typename G::vertices_size_type num_common_neighbors (typename G::vertex_descriptor u, typename G::vertex_descriptor v, const G& g) {
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+    const std::pair<adjacency_iterator, adjacency_iterator> q = adjacent_vertices(v, g);
+    return intersection_size(p.first, p.second, q.first, q.second);}
+
+// ----------------
+// common_neighbors
+// ----------------
+
+/**
+ * @param u is a vertex_descriptor by value
+ * @param v is a vertex_descriptor by value
+ * @param g is a graph by reference
+ * @param x is an output iterator
+ * write the vertices that both u and v have edges to, in order, to x
+ * return the end of the output
+ */
+template <typename G, typename OI>
+OI common_neighbors (typename G::vertex_descriptor u, typename G::vertex_descriptor v, const G& g, OI x) {
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+    const std::pair<adjacency_iterator, adjacency_iterator> q = adjacent_vertices(v, g);
+    return intersection(p.first, p.second, q.first, q.second, x);}
+
+// -------
+// jaccard
+// -------
+
+/**
+ * @param u is a vertex_descriptor by value
+ * @param v is a vertex_descriptor by value
+ * @param g is a graph by reference
+ * return the Jaccard similarity of the out-neighbors of u and v: common / either, 0 when both have none
+ */
+template <typename G>
+double jaccard (typename G::vertex_descriptor u, typename G::vertex_descriptor v, const G& g) {
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+    const std::pair<adjacency_iterator, adjacency_iterator> q = adjacent_vertices(v, g);
+    const double c = intersection_size(p.first, p.second, q.first, q.second);
+    const double n = std::distance(p.first, p.second) + std::distance(q.first, q.second) - c;
+    return (n == 0) ? 0 : (c / n);}
+
+// ---------------------
+// for_each_edge_overlap
+// ---------------------
+
+/**
+ * @param g         is a graph by reference
+ * @param f         is called as f(u, v, i, c) for every edge (u, v) of g, where i is the position of the edge
+ *                  in edges(g) and c the number of common out-neighbors of u and v
+ * @param n_threads is the number of threads, 0 for one per core
+ * sources are handed out in small chunks, so a few high-degree vertices do not hold up one thread;
+ * f is called from many threads at once
+ */
+template <typename G, typename F>
+void for_each_edge_overlap (const G& g, F f, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::size_t        n = num_vertices(g);
+    std::vector<std::size_t> offsets(n + 1, 0);
+    for (std::size_t u = 0; u != n; ++u) {
+        const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(u, g), g);
+        offsets[u + 1] = offsets[u] + std::distance(p.first, p.second);}
+    parallel_chunks(n, default_threads(n_threads, offsets[n], 1 << 12), 1 << 8, [&] (std::size_t, std::size_t b, std::size_t e) {
+        for (std::size_t u = b; u != e; ++u) {
+            const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(u, g), g);
+            std::size_t i = offsets[u];
+            for (adjacency_iterator r = p.first; r != p.second; ++r, ++i) {
+                const vertex_descriptor                                 v = *r;
+                const std::pair<adjacency_iterator, adjacency_iterator> q = adjacent_vertices(v, g);
+                f(static_cast<vertex_descriptor>(u), v, i, intersection_size(p.first, p.second, q.first, q.second));}}});}
+
+// ------------
+// edge_jaccard
+// ------------
+
+/**
+ * @param g         is a graph by reference
+ * @param j         is set to the Jaccard similarity of the endpoints of every edge, in the order of edges(g)
+ * @param n_threads is the number of threads, 0 for one per core
+ */
+template <typename G>
+void edge_jaccard (const G& g, std::vector<double>& j, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    j.assign(num_edges(g), 0);
+    for_each_edge_overlap(g, [&] (vertex_descriptor u, vertex_descriptor v, std::size_t i, std::size_t c) {
+        const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(u, g);
+        const std::pair<adjacency_iterator, adjacency_iterator> q = adjacent_vertices(v, g);
+        const double n = std::distance(p.first, p.second) + std::distance(q.first, q.second) - double(c);
+        j[i] = (n == 0) ? 0 : (c / n);}, n_threads);}
+
+// ----------------
+// orient_by_degree
+// ----------------
+
+/**
+ * @param g         is a graph by reference
+ * @param offsets   is set to the offsets of the result, one per vertex and one more
+ * @param targets   is set to the targets of the result
+ * @param n_threads is the number of threads, 0 for one per core
+ * take g as undirected and simple, dropping self-loops and parallel edges, then keep each edge once,
+ * pointing from its lower-degree end (ties by index); every list stays sorted and no vertex keeps
+ * more than O(sqrt(E)) targets, which bounds the work of counting triangles
+ */
+template <typename G>
+void orient_by_degree (const G& g, std::vector<std::size_t>& offsets, std::vector<typename G::vertex_descriptor>& targets, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    const std::size_t n = num_vertices(g);
+
+    // both directions of every edge, then each list sorted and deduplicated
+    std::vector<std::size_t> count(n + 1, 0);
+    for (std::size_t u = 0; u != n; ++u) {
+        const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(u, g), g);
+        for (adjacency_iterator r = p.first; r != p.second; ++r)
+            if (static_cast<std::size_t>(*r) != u) {
+                ++count[u + 1];
+                ++count[*r + 1];}}
+    for (std::size_t u = 0; u != n; ++u)
+        count[u + 1] += count[u];
+    std::vector<vertex_descriptor> both(count[n]);
+    std::vector<std::size_t>       next(count.begin(), count.end() - 1);
+    for (std::size_t u = 0; u != n; ++u) {
+        const std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(vertex(u, g), g);
+        for (adjacency_iterator r = p.first; r != p.second; ++r)
+            if (static_cast<std::size_t>(*r) != u) {
+                both[next[u]++]  = *r;
+                both[next[*r]++] = vertex(u, g);}}
+    const std::size_t        t = default_threads(n_threads, both.size(), 1 << 14);
+    std::vector<std::size_t> degree(n);
+    parallel_chunks(n, t, 1 << 10, [&] (std::size_t, std::size_t b, std::size_t e) {
+        for (std::size_t u = b; u != e; ++u) {
+            std::sort(both.begin() + count[u], both.begin() + count[u + 1]);
+            degree[u] = std::unique(both.begin() + count[u], both.begin() + count[u + 1]) - (both.begin() + count[u]);}});
+
+    // keep u -> v when u comes before v by degree, then index
+    offsets.assign(n + 1, 0);
+    for (std::size_t u = 0; u != n; ++u)
+        for (std::size_t i = count[u]; i != count[u] + degree[u]; ++i) {
+            const std::size_t v = both[i];
+            offsets[u + 1] += (degree[u] < degree[v]) || ((degree[u] == degree[v]) && (u < v));}
+    for (std::size_t u = 0; u != n; ++u)
+        offsets[u + 1] += offsets[u];
+    targets.resize(offsets[n]);
+    parallel_chunks(n, t, 1 << 10, [&] (std::size_t, std::size_t b, std::size_t e) {
+        for (std::size_t u = b; u != e; ++u) {
+            std::size_t k = offsets[u];
+            for (std::size_t i = count[u]; i != count[u] + degree[u]; ++i) {
+                const std::size_t v = both[i];
+                if ((degree[u] < degree[v]) || ((degree[u] == degree[v]) && (u < v)))
+                    targets[k++] = both[i];}}});}
+
+// --------------
+// triangle_count
+// --------------
+
+/**
+ * @param g         is a graph by reference
+ * @param n_threads is the number of threads, 0 for one per core
+ * return the number of triangles in g taken as undirected: sets of three vertices joined pairwise by
+ * an edge in either direction
+ * every triangle is found once, as the intersection of the oriented lists of its two lower ends
+ */
+template <typename G>
+uint64_t triangle_count (const G& g, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor vertex_descriptor;
+    std::vector<std::size_t>       offsets;
+    std::vector<vertex_descriptor> targets;
+    orient_by_degree(g, offsets, targets, n_threads);
+    const std::size_t     n = offsets.size() - 1;
+    const std::size_t     t = default_threads(n_threads, targets.size(), 1 << 12);
+    std::vector<uint64_t> sums(t, 0);
+    parallel_chunks(n, t, 1 << 8, [&] (std::size_t k, std::size_t b, std::size_t e) {
+        uint64_t s = 0;
+        for (std::size_t u = b; u != e; ++u)
+            for (std::size_t i = offsets[u]; i != offsets[u + 1]; ++i) {
+                const std::size_t v = targets[i];
+                s += intersect(targets.data() + offsets[u], offsets[u + 1] - offsets[u],
+                               targets.data() + offsets[v], offsets[v + 1] - offsets[v]);}
+        sums[k] += s;});
+    uint64_t s = 0;
+    for (std::size_t k = 0; k != t; ++k)
+        s += sums[k];
+    return s;}
+
+// ---------------
+// triangle_counts
+// ---------------
+
+/**
+ * @param g         is a graph by reference
+ * @param c         is set to the number of triangles through each vertex, as in triangle_count
+ * @param n_threads is the number of threads, 0 for one per core
+ * return the number of triangles in g
+ */
+template <typename G>
+uint64_t triangle_counts (const G& g, std::vector<uint64_t>& c, std::size_t n_threads = 0) {
+    typedef typename G::vertex_descriptor vertex_descriptor;
+    std::vector<std::size_t>       offsets;
+    std::vector<vertex_descriptor> targets;
+    orient_by_degree(g, offsets, targets, n_threads);
+    const std::size_t n = offsets.size() - 1;
+    const std::size_t t = default_threads(n_threads, targets.size(), 1 << 12);
+    std::vector< std::atomic<uint64_t> > a(n);
+    for (std::size_t u = 0; u != n; ++u)
+        a[u].store(0, std::memory_order_relaxed);
+    parallel_chunks(n, t, 1 << 8, [&] (std::size_t, std::size_t b, std::size_t e) {
+        std::vector<vertex_descriptor> w;
+        for (std::size_t u = b; u != e; ++u) {
+            uint64_t s = 0;
+            for (std::size_t i = offsets[u]; i != offsets[u + 1]; ++i) {
+                const std::size_t v = targets[i];
+                w.resize(std::min(offsets[u + 1] - offsets[u], offsets[v + 1] - offsets[v]));
+                const std::size_t k = intersect(targets.data() + offsets[u], offsets[u + 1] - offsets[u],
+                                                targets.data() + offsets[v], offsets[v + 1] - offsets[v], w.data());
+                s += k;
+                a[v].fetch_add(k, std::memory_order_relaxed);
+                for (std::size_t j = 0; j != k; ++j)
+                    a[w[j]].fetch_add(1, std::memory_order_relaxed);}
+            a[u].fetch_add(s, std::memory_order_relaxed);}});
+    c.resize(n);
+    uint64_t s = 0;
+    for (std::size_t u = 0; u != n; ++u) {
+        c[u] = a[u].load(std::memory_order_relaxed);
+        s   += c[u];}
+    return s / 3;}
+
 #endif // Graph_h
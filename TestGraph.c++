@@ -29,6 +29,10 @@ To compile the test:
 To run the test:
     % valgrind TestGraph
 
+To run the concurrency tests under ThreadSanitizer:
+    % g++ -g -O1 -fsanitize=thread -pedantic -std=c++11 TestGraph.c++ -o TestGraphTSan -lgtest -lgtest_main -lpthread
+    % TestGraphTSan --gtest_filter='TestGraphConcurrent.*'
+
 To obtain coverage of the test:
     % gcov-4.7 -b Graph.c++ TestGraph.c++
 */
@@ -37,13 +41,21 @@ To obtain coverage of the test:
 // includes
 // --------
 
+#include <atomic>   // atomic
+#include <cstdio>   // remove
+#include <fstream>  // fstream
 #include <iostream> // cout, endl
 #include <iterator> // ostream_iterator
+#include <random>   // mt19937
 #include <sstream>  // ostringstream
+#include <thread>   // thread
 #include <utility>  // pair
 
-#include "boost/graph/adjacency_list.hpp"  // adjacency_list
-#include "boost/graph/topological_sort.hpp"// topological_sort
+#include "boost/graph/adjacency_list.hpp"        // adjacency_list
+#include "boost/graph/breadth_first_search.hpp"  // breadth_first_search
+#include "boost/graph/connected_components.hpp"  // connected_components
+#include "boost/graph/strong_components.hpp"     // strong_components
+#include "boost/graph/topological_sort.hpp"      // topological_sort
 
 #include "gtest/gtest.h"
 
@@ -83,7 +95,9 @@ struct TestGraph : testing::Test {
 // possibly cyclic
 typedef testing::Types<
             boost::adjacency_list<boost::setS, boost::vecS, boost::directedS>,
-            Graph>
+            Graph,
+            BasicGraph<uint32_t>,
+            BasicGraph<uint64_t> >
         my_types;
 
 TYPED_TEST_CASE(TestGraph, my_types);
@@ -559,6 +573,35 @@ TYPED_TEST(TestGraph, Edge_5) {
     ASSERT_EQ(3, num_edges(g));
 }
 
+TYPED_TEST(TestGraph, Edge_6) {
+    DEFS
+
+    graph_type g;
+    for (int i = 0; i < 100; ++i)
+        add_edge(i % 10, (i * 37) % 100, g);
+
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(edge(i % 10, (i * 37) % 100, g).second);
+        ASSERT_FALSE(edge((i % 10) + 10, (i * 37) % 100, g).second);}
+    ASSERT_EQ(100, num_edges(g));}
+
+TYPED_TEST(TestGraph, Edge_7) {
+    DEFS
+
+    graph_type g;
+    add_edge(5, 3, g);
+    add_edge(5, 9, g);
+    add_edge(5, 1, g);
+
+    ASSERT_TRUE(edge(5, 1, g).second);
+    ASSERT_TRUE(edge(5, 3, g).second);
+    ASSERT_TRUE(edge(5, 9, g).second);
+    ASSERT_FALSE(edge(5, 0, g).second);
+    ASSERT_FALSE(edge(5, 2, g).second);
+    ASSERT_FALSE(edge(5, 5, g).second);
+    ASSERT_FALSE(edge(3, 5, g).second);
+    ASSERT_FALSE(edge(9, 5, g).second);}
+
 // -----
 // edges
 // -----
@@ -1064,3 +1107,1446 @@ TYPED_TEST(TestGraph, Vertices_3) {
     --e;
 
     ASSERT_EQ(100,*e);}
+
+// ---------
+// add_edges
+// ---------
+
+TEST(TestGraphBulk, Add_Edges_1) {
+    Graph g;
+    std::vector<Graph::edge_descriptor> x;
+
+    ASSERT_EQ(0, add_edges(x.begin(), x.end(), g));
+    ASSERT_EQ(0, num_vertices(g));
+    ASSERT_EQ(0, num_edges(g));}
+
+TEST(TestGraphBulk, Add_Edges_2) {
+    Graph g;
+    add_edge(0, 2, g);
+    std::vector<Graph::edge_descriptor> x;
+    x.push_back(std::make_pair(3, 1));
+    x.push_back(std::make_pair(0, 2));
+    x.push_back(std::make_pair(0, 1));
+    x.push_back(std::make_pair(3, 1));
+    x.push_back(std::make_pair(0, 7));
+
+    ASSERT_EQ(3, add_edges(x.begin(), x.end(), g));
+    ASSERT_EQ(8, num_vertices(g));
+    ASSERT_EQ(4, num_edges(g));
+    ASSERT_TRUE(edge(0, 1, g).second);
+    ASSERT_TRUE(edge(0, 2, g).second);
+    ASSERT_TRUE(edge(0, 7, g).second);
+    ASSERT_TRUE(edge(3, 1, g).second);
+
+    std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> p = adjacent_vertices(0, g);
+    ASSERT_EQ(1, p.first[0]);
+    ASSERT_EQ(2, p.first[1]);
+    ASSERT_EQ(7, p.first[2]);
+    ASSERT_EQ(3, p.second - p.first);}
+
+TEST(TestGraphBulk, Add_Edges_3) {
+    std::vector<Graph::edge_descriptor> x;
+    for (int i = 0; i < 300000; ++i)
+        x.push_back(std::make_pair(i % 1000, (i * 31) % 211));
+
+    Graph g;
+    for (std::size_t i = 0; i != x.size() / 2; ++i)
+        add_edge(x[i].first, x[i].second, g);
+    Graph h1 = g;
+    Graph h4 = g;
+    for (std::size_t i = x.size() / 2; i != x.size(); ++i)
+        add_edge(x[i].first, x[i].second, g);
+    add_edges(x.begin() + x.size() / 2, x.end(), h1, 1);
+    add_edges(x.begin() + x.size() / 2, x.end(), h4, 4);
+
+    ASSERT_EQ(num_vertices(g), num_vertices(h1));
+    ASSERT_EQ(num_vertices(g), num_vertices(h4));
+    ASSERT_EQ(num_edges(g), num_edges(h1));
+    ASSERT_EQ(num_edges(g), num_edges(h4));
+    ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(h1).first));
+    ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(h4).first));
+    for (int v = 0; v < 1000; ++v) {
+        std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> p = adjacent_vertices(v, g);
+        std::pair<Graph::adjacency_iterator, Graph::adjacency_iterator> q = adjacent_vertices(v, h4);
+        ASSERT_EQ(p.second - p.first, q.second - q.first);
+        ASSERT_TRUE(std::equal(p.first, p.second, q.first));}}
+
+// ----------
+// BasicGraph
+// ----------
+
+TEST(TestGraphBasic, Basic_Size) {
+    ASSERT_EQ(sizeof(std::vector<int>), sizeof(GraphAdjacency<int>));
+    ASSERT_EQ(4u, GraphAdjacency<uint32_t>::inline_capacity);
+    ASSERT_EQ(2u, GraphAdjacency<uint64_t>::inline_capacity);}
+
+TEST(TestGraphBasic, Basic_Spill) {
+    BasicGraph<uint32_t> g;
+    for (uint32_t v = 40; v != 0; --v) {
+        ASSERT_TRUE(add_edge(0, v, g).second);
+        ASSERT_FALSE(add_edge(0, v, g).second);}
+    ASSERT_EQ(40u, num_edges(g));
+    ASSERT_EQ(41u, num_vertices(g));
+    std::pair<BasicGraph<uint32_t>::adjacency_iterator, BasicGraph<uint32_t>::adjacency_iterator> p = adjacent_vertices(0, g);
+    ASSERT_EQ(40, p.second - p.first);
+    for (uint32_t v = 1; v != 41; ++v)
+        ASSERT_EQ(v, p.first[v - 1]);}
+
+TEST(TestGraphBasic, Basic_Copy) {
+    typedef BasicGraph<uint32_t> graph_type;
+    graph_type g;
+    for (uint32_t v = 0; v != 20; ++v)
+        add_edge(v % 3, v, g);
+    graph_type h = g;
+    add_edge(0, 100, g);
+    ASSERT_EQ(20u, num_edges(h));
+    ASSERT_EQ(21u, num_edges(g));
+    ASSERT_FALSE(edge(0, 100, h).second);
+    h = g;
+    ASSERT_TRUE(edge(0, 100, h).second);
+    graph_type k = std::move(h);
+    ASSERT_EQ(0u, num_edges(h));
+    ASSERT_EQ(0u, num_vertices(h));
+    ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(k).first));}
+
+TEST(TestGraphBasic, Basic_Arena) {
+    typedef BasicGraph<uint32_t, ArenaAllocator<uint32_t> > graph_type;
+    std::vector<std::pair<int, int> > x;
+    for (int i = 0; i != 50000; ++i)
+        x.push_back(std::make_pair(i % 1000, (i * 31) % 211));
+    Graph      g;
+    GraphArena arena;
+    graph_type h((ArenaAllocator<uint32_t>(arena)));
+    for (std::size_t i = 0; i != x.size() / 2; ++i) {
+        add_edge(x[i].first, x[i].second, g);
+        add_edge(x[i].first, x[i].second, h);}
+    add_edges(x.begin() + x.size() / 2, x.end(), g, 1);
+    add_edges(x.begin() + x.size() / 2, x.end(), h, 4);
+    ASSERT_NE(0u, arena.reserved());
+    ASSERT_EQ(num_vertices(g), num_vertices(h));
+    ASSERT_EQ(num_edges(g), num_edges(h));
+    graph_type k = h;
+    ASSERT_EQ(num_edges(g), num_edges(k));
+    for (std::pair<Graph::edge_iterator, Graph::edge_iterator> p = edges(g); p.first != p.second; ++p.first)
+        ASSERT_TRUE(edge((*p.first).first, (*p.first).second, k).second);}
+
+// an allocator that is not safe to share, counting the calls made off the thread that built it
+template <typename T>
+struct OwnerAllocator {
+    typedef T value_type;
+
+    std::thread::id   owner;
+    std::atomic<int>* strays;
+
+    explicit OwnerAllocator (std::atomic<int>& s) :
+            owner  (std::this_thread::get_id()),
+            strays (&s)
+        {}
+
+    template <typename U>
+    OwnerAllocator (const OwnerAllocator<U>& that) :
+            owner  (that.owner),
+            strays (that.strays)
+        {}
+
+    T* allocate (std::size_t n) {
+        if (std::this_thread::get_id() != owner)
+            ++*strays;
+        return std::allocator<T>().allocate(n);}
+
+    void deallocate (T* p, std::size_t n) {
+        if (std::this_thread::get_id() != owner)
+            ++*strays;
+        std::allocator<T>().deallocate(p, n);}
+
+    friend bool operator == (const OwnerAllocator& lhs, const OwnerAllocator& rhs) {
+        return lhs.strays == rhs.strays;}
+
+    friend bool operator != (const OwnerAllocator& lhs, const OwnerAllocator& rhs) {
+        return !(lhs == rhs);}};
+
+TEST(TestGraphBasic, Basic_Allocator_Thread) {
+    typedef BasicGraph<uint32_t, OwnerAllocator<uint32_t> > graph_type;
+    std::vector<std::pair<int, int> > x;
+    for (int i = 0; i != 200000; ++i)
+        x.push_back(std::make_pair(i % 5000, (i * 31) % 4001));
+    std::atomic<int>     strays(0);
+    BasicGraph<uint32_t> g;
+    {
+    graph_type h((OwnerAllocator<uint32_t>(strays)));
+    add_edges(x.begin(), x.begin() + x.size() / 2, h, 4);
+    add_edges(x.begin() + x.size() / 2, x.end(), h, 4);
+    add_edges(x.begin(), x.end(), g, 1);
+    ASSERT_EQ(num_edges(g), num_edges(h));
+    ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(h).first));
+    }
+    ASSERT_EQ(0, strays.load());}
+
+// ----------
+// read_edges
+// ----------
+
+TEST(TestGraphRead, Read_Edges_1) {
+    std::istringstream in("# Directed graph: example.txt\n"
+                          "# FromNodeId\tToNodeId\n"
+                          "0\t1\n"
+                          "0 2\n"
+                          "\n"
+                          "  3   1  0.5\n"
+                          "0\t1\n"
+                          "x y\n"
+                          "4\n"
+                          "-1 2\n"
+                          "5 6x\n"
+                          "2 0");
+    Graph g;
+    GraphReadStats s = read_edges(in, g, 2, 8);
+
+    ASSERT_TRUE(s.complete);
+    ASSERT_EQ(5, s.edges);
+    ASSERT_EQ(4, s.added);
+    ASSERT_EQ(4, s.rejected);
+    ASSERT_EQ(in.str().size(), s.bytes);
+    ASSERT_EQ(4, num_edges(g));
+    ASSERT_EQ(4, num_vertices(g));
+    ASSERT_TRUE(edge(0, 1, g).second);
+    ASSERT_TRUE(edge(0, 2, g).second);
+    ASSERT_TRUE(edge(3, 1, g).second);
+    ASSERT_TRUE(edge(2, 0, g).second);}
+
+TEST(TestGraphRead, Read_Edges_2) {
+    std::istringstream in("%%MatrixMarket matrix coordinate pattern general\n"
+                          "% a comment\n"
+                          "3 3 3\n"
+                          "1 2\n"
+                          "2 3\n"
+                          "3 1\n"
+                          "0 1\n");
+    Graph g;
+    GraphReadStats s = read_edges(in, g, 1, 5);
+
+    ASSERT_EQ(3, s.edges);
+    ASSERT_EQ(1, s.rejected);
+    ASSERT_EQ(3, num_vertices(g));
+    ASSERT_TRUE(edge(0, 1, g).second);
+    ASSERT_TRUE(edge(1, 2, g).second);
+    ASSERT_TRUE(edge(2, 0, g).second);}
+
+TEST(TestGraphRead, Read_Edges_3) {
+    std::ostringstream out;
+    Graph g;
+    for (int i = 0; i < 20000; ++i) {
+        const int u = (i * 31) % 997;
+        const int v = (i * 17) % 1009;
+        out << u << ((i % 2) ? "\t" : " ") << v << "\n";
+        if (i % 1000 == 0)
+            out << "# checkpoint " << i << "\n";
+        add_edge(u, v, g);}
+
+    for (std::size_t chunk_size = 1; chunk_size <= 4096; chunk_size *= 16) {
+        std::istringstream in(out.str());
+        Graph h;
+        GraphReadStats s = read_edges(in, h, 3, chunk_size);
+        ASSERT_EQ(3, s.parsers);
+        ASSERT_EQ(20000, s.edges);
+        ASSERT_EQ(0, s.rejected);
+        ASSERT_EQ(num_edges(g), s.added);
+        ASSERT_EQ(num_vertices(g), num_vertices(h));
+        ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(h).first));}}
+
+TEST(TestGraphRead, Read_Edges_4) {
+    Graph g;
+    GraphReadStats s = read_edges("TestGraph.missing", g);
+
+    ASSERT_FALSE(s.complete);
+    ASSERT_EQ(0, s.bytes);
+    ASSERT_EQ(0, num_vertices(g));}
+
+TEST(TestGraphRead, Parse_Edge_Wide) {
+    const std::string a = "18446744073709551615 4294967296";
+    const std::string b = "18446744073709551616 1";
+    const std::string c = "65535 1";
+    const std::string d = "65536 1";
+    std::pair<uint64_t, uint64_t> x;
+    std::pair<uint16_t, uint16_t> y;
+    ASSERT_EQ(1, parse_edge(a.data(), a.data() + a.size(), false, x));
+    ASSERT_EQ(std::numeric_limits<uint64_t>::max(), x.first);
+    ASSERT_EQ(uint64_t(1) << 32, x.second);
+    ASSERT_EQ(-1, parse_edge(b.data(), b.data() + b.size(), false, x));
+    ASSERT_EQ(1,  parse_edge(c.data(), c.data() + c.size(), false, y));
+    ASSERT_EQ(65535, y.first);
+    ASSERT_EQ(-1, parse_edge(d.data(), d.data() + d.size(), false, y));}
+
+TEST(TestGraphRead, Read_Edges_Unsigned) {
+    std::istringstream in("# u64\n"
+                          "0 1\n"
+                          "1 2\n"
+                          "2 0\n");
+    BasicGraph<uint64_t> g;
+    GraphReadStats s = read_edges(in, g, 2, 4);
+    ASSERT_EQ(3, s.added);
+    ASSERT_EQ(3, num_vertices(g));
+    ASSERT_TRUE(edge(2, 0, g).second);}
+
+// ---------------
+// TestGraphFrozen
+// ---------------
+
+// read-only views built from a BasicGraph with the same vertex_descriptor, checked against the graph itself
+
+template <typename G>
+struct TestGraphFrozen : testing::Test {
+    // --------
+    // typedefs
+    // --------
+
+    typedef          G                     graph_type;
+    typedef typename G::vertex_descriptor  vertex_descriptor;
+    typedef typename G::edge_descriptor    edge_descriptor;
+    typedef typename G::vertex_iterator    vertex_iterator;
+    typedef typename G::edge_iterator      edge_iterator;
+    typedef typename G::adjacency_iterator adjacency_iterator;
+    typedef typename G::vertices_size_type vertices_size_type;
+    typedef typename G::edges_size_type    edges_size_type;
+
+    typedef BasicGraph<vertex_descriptor> source_type;
+
+    // ------
+    // freeze
+    // ------
+
+    template <typename F>
+    static F freeze (const source_type& g, F*) {
+        return F(g);}
+
+    template <typename V>
+    static BasicGraphMapped<V> freeze (const source_type& g, BasicGraphMapped<V>*) {
+        const std::string path = "TestGraph.tmp";
+        save(g, path);
+        BasicGraphMapped<V> m(path);
+        std::remove(path.c_str());
+        return m;}
+
+    static G freeze (const source_type& g) {
+        return freeze(g, static_cast<G*>(0));}};
+
+typedef testing::Types<
+            Graph,
+            GraphCSR,
+            GraphMapped,
+            BasicGraphCSR<uint32_t>,
+            BasicGraphMapped<uint32_t> >
+        frozen_types;
+
+TYPED_TEST_CASE(TestGraphFrozen, frozen_types);
+
+TYPED_TEST(TestGraphFrozen, Frozen_Empty) {
+    DEFS
+
+    typename TestFixture::source_type g;
+    graph_type f = TestFixture::freeze(g);
+
+    ASSERT_EQ(0, num_vertices(f));
+    ASSERT_EQ(0, num_edges(f));
+    ASSERT_TRUE(edges(f).first == edges(f).second);
+    ASSERT_TRUE(vertices(f).first == vertices(f).second);}
+
+TYPED_TEST(TestGraphFrozen, Frozen_Vertices) {
+    DEFS
+
+    typename TestFixture::source_type g;
+    add_vertex(g);
+    add_edge(0, 5, g);
+    graph_type f = TestFixture::freeze(g);
+
+    std::pair<vertex_iterator, vertex_iterator> p = vertices(f);
+    vertex_iterator b = p.first;
+    vertex_iterator e = p.second;
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_EQ(i, *b);
+        ++b;}
+    ASSERT_TRUE(b == e);
+    ASSERT_EQ(5, *(--e));
+    ASSERT_EQ(6, num_vertices(f));
+    ASSERT_EQ(3, vertex(3, f));}
+
+TYPED_TEST(TestGraphFrozen, Frozen_Edges) {
+    DEFS
+
+    typename TestFixture::source_type g;
+    add_edge(3, 1, g);
+    add_edge(0, 2, g);
+    add_edge(0, 1, g);
+    add_edge(3, 3, g);
+    graph_type f = TestFixture::freeze(g);
+
+    std::pair<edge_iterator, edge_iterator> p = edges(f);
+    edge_iterator b = p.first;
+    edge_iterator e = p.second;
+    ASSERT_EQ(edge_descriptor(0, 1), *b);
+    ++b;
+    ASSERT_EQ(edge_descriptor(0, 2), *b);
+    ++b;
+    ASSERT_EQ(edge_descriptor(3, 1), *b);
+    ++b;
+    edge_descriptor ed = *b;
+    ASSERT_EQ(3, source(ed, f));
+    ASSERT_EQ(3, target(ed, f));
+    ++b;
+    ASSERT_TRUE(b == e);
+    ASSERT_EQ(4, num_edges(f));}
+
+TYPED_TEST(TestGraphFrozen, Frozen_Adjacent_Vertices) {
+    DEFS
+
+    typename TestFixture::source_type g;
+    add_edge(0, 4, g);
+    add_edge(0, 2, g);
+    add_edge(0, 0, g);
+    add_edge(2, 4, g);
+    graph_type f = TestFixture::freeze(g);
+
+    std::pair<adjacency_iterator, adjacency_iterator> p = adjacent_vertices(0, f);
+    adjacency_iterator b = p.first;
+    adjacency_iterator e = p.second;
+    ASSERT_EQ(0, *b);
+    ++b;
+    ASSERT_EQ(2, *b);
+    ++b;
+    ASSERT_EQ(4, *b);
+    ++b;
+    ASSERT_TRUE(b == e);
+
+    p = adjacent_vertices(1, f);
+    ASSERT_TRUE(p.first == p.second);}
+
+TYPED_TEST(TestGraphFrozen, Frozen_Edge) {
+    DEFS
+
+    typename TestFixture::source_type g;
+    for (int i = 0; i < 50; ++i)
+        add_edge(i % 5, i, g);
+    graph_type f = TestFixture::freeze(g);
+
+    for (int i = 0; i < 50; ++i) {
+        ASSERT_TRUE(edge(i % 5, i, f).second);
+        ASSERT_FALSE(edge(i % 5, i + 1, f).second);}
+    ASSERT_FALSE(edge(49, 0, f).second);
+    ASSERT_EQ(edge_descriptor(2, 7), edge(2, 7, f).first);}
+
+TYPED_TEST(TestGraphFrozen, Frozen_Matches_Graph) {
+    DEFS
+
+    typename TestFixture::source_type g;
+    for (int i = 0; i < 200; ++i)
+        add_edge((i * 7) % 31, (i * 13) % 37, g);
+    graph_type f = TestFixture::freeze(g);
+
+    ASSERT_EQ(num_vertices(g), num_vertices(f));
+    ASSERT_EQ(num_edges(g), num_edges(f));
+
+    std::pair<typename TestFixture::source_type::edge_iterator, typename TestFixture::source_type::edge_iterator> pg = edges(g);
+    std::pair<edge_iterator, edge_iterator>               pf = edges(f);
+    while (pg.first != pg.second) {
+        ASSERT_TRUE(pf.first != pf.second);
+        ASSERT_EQ(*pg.first, *pf.first);
+        ++pg.first;
+        ++pf.first;}
+    ASSERT_TRUE(pf.first == pf.second);}
+
+// -----------
+// GraphMapped
+// -----------
+
+TEST(TestGraphMapped, Mapped_Open) {
+    Graph g;
+    add_edge(0, 1, g);
+    add_edge(1, 2, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_TRUE(m.is_open());
+    ASSERT_EQ(3, num_vertices(m));
+    ASSERT_EQ(2, num_edges(m));
+    ASSERT_TRUE(edge(1, 2, m).second);}
+
+TEST(TestGraphMapped, Mapped_Missing) {
+    GraphMapped m("TestGraph.missing");
+    ASSERT_FALSE(m.is_open());
+    ASSERT_EQ(0, num_vertices(m));
+    ASSERT_EQ(0, num_edges(m));
+    ASSERT_TRUE(edges(m).first == edges(m).second);}
+
+TEST(TestGraphMapped, Mapped_Bad_Header) {
+    Graph g;
+    add_edge(0, 1, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    {
+    std::fstream f("TestGraph.tmp", std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(8);
+    const uint32_t version = GraphHeader::version_number + 1;
+    f.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    }
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_FALSE(m.is_open());
+    ASSERT_EQ(0, num_vertices(m));}
+
+TEST(TestGraphMapped, Mapped_Truncated) {
+    Graph g;
+    add_edge(0, 1, g);
+    add_edge(0, 2, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    ASSERT_EQ(0, truncate("TestGraph.tmp", sizeof(GraphHeader) + 4 * sizeof(uint64_t) + sizeof(int)));
+
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_FALSE(m.is_open());}
+
+TEST(TestGraphMapped, Mapped_Bad_Offsets) {
+    Graph g;
+    add_edge(0, 1, g);
+    add_edge(0, 2, g);
+    add_edge(1, 2, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    {
+    std::fstream f("TestGraph.tmp", std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(sizeof(GraphHeader) + 3 * sizeof(uint64_t));
+    const uint64_t o = 1000000;
+    f.write(reinterpret_cast<const char*>(&o), sizeof(o));
+    }
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_FALSE(m.is_open());
+    ASSERT_EQ(0, num_edges(m));}
+
+TEST(TestGraphMapped, Mapped_Verify) {
+    Graph g;
+    add_edge(0, 1, g);
+    add_edge(1, 2, g);
+    add_edge(2, 0, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    {
+    GraphMapped m("TestGraph.tmp");
+    ASSERT_TRUE(m.verify());
+    }
+    {
+    std::fstream f("TestGraph.tmp", std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(sizeof(GraphHeader) + 1 * sizeof(uint64_t));
+    const uint64_t o = 3;
+    f.write(reinterpret_cast<const char*>(&o), sizeof(o));
+    }
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_TRUE(m.is_open());
+    ASSERT_FALSE(m.verify());}
+
+TEST(TestGraphMapped, Mapped_Verify_Targets) {
+    Graph g;
+    add_edge(0, 1, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    {
+    std::fstream f("TestGraph.tmp", std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(sizeof(GraphHeader) + 3 * sizeof(uint64_t));
+    const int v = 7;
+    f.write(reinterpret_cast<const char*>(&v), sizeof(v));
+    }
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_TRUE(m.is_open());
+    ASSERT_FALSE(m.verify());}
+
+TEST(TestGraphMapped, Mapped_Save_Threads) {
+    std::vector<Graph> g(4);
+    for (int t = 0; t != 4; ++t)
+        for (int i = 0; i != 20000; ++i)
+            add_edge(i, (i + t + 1) % 20000, g[t]);
+    std::vector<std::thread> threads;
+    std::atomic<int>         saved(0);
+    for (int t = 0; t != 4; ++t)
+        threads.push_back(std::thread([&, t] () {
+            saved += save(g[t], "TestGraph.tmp");}));
+    for (std::size_t t = 0; t != threads.size(); ++t)
+        threads[t].join();
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_EQ(4, saved);
+    ASSERT_TRUE(m.is_open());
+    ASSERT_TRUE(m.verify());
+    bool b = false;
+    for (int t = 0; t != 4; ++t)
+        b = b || std::equal(edges(g[t]).first, edges(g[t]).second, edges(m).first);
+    ASSERT_TRUE(b);}
+
+TEST(TestGraphMapped, Mapped_Replace) {
+    Graph g;
+    add_edge(0, 1, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    GraphMapped m("TestGraph.tmp");
+    add_edge(1, 2, g);
+    add_edge(2, 0, g);
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    GraphMapped n("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_EQ(1, num_edges(m));
+    ASSERT_TRUE(edge(0, 1, m).second);
+    ASSERT_EQ(3, num_edges(n));
+    ASSERT_TRUE(edge(2, 0, n).second);}
+
+TEST(TestGraphMapped, Mapped_Save_CSR) {
+    Graph g;
+    for (int i = 0; i < 100; ++i)
+        add_edge(i, (i * 3) % 100, g);
+    ASSERT_TRUE(save(GraphCSR(g), "TestGraph.tmp"));
+
+    GraphMapped m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_EQ(100, num_edges(m));
+    ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(m).first));}
+
+// --------
+// GraphBFS
+// --------
+
+typedef boost::adjacency_list<boost::setS, boost::vecS, boost::directedS>   boost_directed;
+typedef boost::adjacency_list<boost::setS, boost::vecS, boost::undirectedS> boost_undirected;
+
+/**
+ * the same random edges in a Graph and in boost graph B over n vertices
+ */
+template <typename B>
+void random_graph (int n, int m, unsigned seed, Graph& g, B& b) {
+    std::mt19937 r(seed);
+    std::uniform_int_distribution<int> d(0, n - 1);
+    for (int v = 0; v != n; ++v) {
+        add_vertex(g);
+        add_vertex(b);}
+    for (int i = 0; i != m; ++i) {
+        const int u = d(r);
+        const int v = d(r);
+        add_edge(u, v, g);
+        add_edge(u, v, b);}}
+
+/**
+ * depths from s in b, by boost
+ */
+std::vector<int> boost_depths (const boost_directed& b, int s) {
+    std::vector<int> x(num_vertices(b), -1);
+    x[s] = 0;
+    boost::breadth_first_search(b, s, boost::visitor(boost::make_bfs_visitor(boost::record_distances(&x[0], boost::on_tree_edge()))));
+    return x;}
+
+TEST(TestGraphBFS, BFS_1) {
+    Graph g;
+    add_edge(0, 1, g);
+    add_edge(0, 2, g);
+    add_edge(1, 3, g);
+    add_edge(2, 3, g);
+    add_edge(3, 4, g);
+    add_edge(5, 0, g);
+
+    std::vector<int> parent;
+    std::vector<int> depth;
+    ASSERT_EQ(5, breadth_first_search(g, 0, parent, depth));
+    ASSERT_EQ( 0, parent[0]);
+    ASSERT_EQ( 0, parent[1]);
+    ASSERT_EQ( 0, parent[2]);
+    ASSERT_EQ( 3, parent[4]);
+    ASSERT_EQ(-1, parent[5]);
+    ASSERT_EQ( 0, depth[0]);
+    ASSERT_EQ( 2, depth[3]);
+    ASSERT_EQ( 3, depth[4]);
+    ASSERT_EQ(-1, depth[5]);}
+
+TEST(TestGraphBFS, BFS_2) {
+    Graph          g;
+    boost_directed b;
+    random_graph(3000, 30000, 1, g, b);
+    const std::vector<int> expected = boost_depths(b, 7);
+
+    for (std::size_t n_threads = 1; n_threads <= 4; n_threads *= 2) {
+        std::vector<int> parent;
+        std::vector<int> depth;
+        breadth_first_search(GraphCSR(g), 7, parent, depth, n_threads);
+        ASSERT_EQ(expected, depth);
+        for (int v = 0; v != 3000; ++v) {
+            if ((v == 7) || (depth[v] == -1))
+                continue;
+            ASSERT_TRUE(edge(parent[v], v, g).second);
+            ASSERT_EQ(depth[v] - 1, depth[parent[v]]);}}}
+
+TEST(TestGraphBFS, BFS_3) {
+    Graph g;
+    std::vector<Graph::edge_descriptor> x;
+    for (int v = 0; v != 200000; ++v)
+        x.push_back(std::make_pair(v, v + 1));
+    add_edges(x.begin(), x.end(), g);
+
+    std::vector<int> parent;
+    std::vector<int> depth;
+    ASSERT_EQ(200001, breadth_first_search(g, 0, parent, depth, 2));
+    ASSERT_EQ(200000, depth[200000]);
+    ASSERT_EQ(199999, parent[200000]);}
+
+TEST(TestGraphBFS, BFS_4) {
+    Graph          g;
+    boost_directed b;
+    random_graph(20000, 100000, 6, g, b);
+    const std::vector<int> expected = boost_depths(b, 3);
+
+    GraphBFS bfs(g, 4);
+    ASSERT_EQ(4, bfs.threads());
+    bfs.run(3);
+    ASSERT_EQ(expected, bfs.depth());
+    for (int v = 0; v != 20000; ++v)
+        if ((v != 3) && (bfs.depth()[v] != -1)) {
+            ASSERT_TRUE(edge(bfs.parent()[v], v, g).second);
+            ASSERT_EQ(bfs.depth()[v] - 1, bfs.depth()[bfs.parent()[v]]);}}
+
+TEST(TestGraphBFS, BFS_Reuse) {
+    Graph          g;
+    boost_directed b;
+    random_graph(5000, 20000, 9, g, b);
+
+    GraphBFS bfs(g, 2);
+    for (int s = 0; s != 5; ++s) {
+        std::vector<int> parent;
+        std::vector<int> depth;
+        const std::vector<int> expected = boost_depths(b, s * 1000);
+        ASSERT_EQ(std::count_if(expected.begin(), expected.end(), [] (int d) {return d != -1;}),
+                  breadth_first_search(bfs, s * 1000, parent, depth));
+        ASSERT_EQ(expected, depth);
+        ASSERT_EQ(s * 1000, parent[s * 1000]);}}
+
+TEST(TestGraphBFS, WCC_1) {
+    Graph            g;
+    boost_undirected b;
+    random_graph(5000, 3000, 2, g, b);
+
+    std::vector<int> expected(5000);
+    const int        k = boost::connected_components(b, &expected[0]);
+    relabel_labels(expected);
+
+    for (std::size_t n_threads = 1; n_threads <= 4; n_threads *= 2) {
+        std::vector<int> component;
+        ASSERT_EQ(k, weakly_connected_components(g, component, n_threads));
+        ASSERT_EQ(expected, component);}}
+
+TEST(TestGraphBFS, SCC_1) {
+    Graph g;
+    add_edge(0, 1, g);
+    add_edge(1, 2, g);
+    add_edge(2, 0, g);
+    add_edge(2, 3, g);
+    add_edge(3, 4, g);
+    add_edge(4, 3, g);
+    add_edge(5, 5, g);
+
+    std::vector<int> component;
+    ASSERT_EQ(3, strongly_connected_components(g, component));
+    ASSERT_EQ(0, component[0]);
+    ASSERT_EQ(0, component[1]);
+    ASSERT_EQ(0, component[2]);
+    ASSERT_EQ(1, component[3]);
+    ASSERT_EQ(1, component[4]);
+    ASSERT_EQ(2, component[5]);}
+
+TEST(TestGraphBFS, SCC_2) {
+    for (int m = 2000; m <= 8000; m *= 2) {
+        Graph          g;
+        boost_directed b;
+        random_graph(4000, m, 3, g, b);
+
+        std::vector<int> expected(4000);
+        const int        k = boost::strong_components(b, &expected[0]);
+        relabel_labels(expected);
+
+        std::vector<int> component;
+        ASSERT_EQ(k, strongly_connected_components(g, component, 3));
+        ASSERT_EQ(expected, component);}}
+
+TEST(TestGraphBFS, SCC_3) {
+    Graph g;
+    std::vector<Graph::edge_descriptor> x;
+    for (int v = 0; v != 100000; ++v)
+        x.push_back(std::make_pair(v, v + 1));
+    x.push_back(std::make_pair(100000, 50000));
+    add_edges(x.begin(), x.end(), g);
+
+    std::vector<int> component;
+    ASSERT_EQ(50001, strongly_connected_components(g, component));
+    ASSERT_EQ(component[50000], component[100000]);
+    ASSERT_NE(component[49999], component[50000]);}
+
+TEST(TestGraphBFS, SCC_4) {
+    Graph            g;
+    boost_directed   b;
+    boost_undirected c(20000);
+    random_graph(20000, 25000, 7, g, b);
+    for (std::pair<Graph::edge_iterator, Graph::edge_iterator> p = edges(g); p.first != p.second; ++p.first)
+        add_edge((*p.first).first, (*p.first).second, c);
+
+    std::vector<int> expected(20000);
+    const int        k = boost::strong_components(b, &expected[0]);
+    relabel_labels(expected);
+    std::vector<int> component;
+    ASSERT_EQ(k, strongly_connected_components(g, component, 4));
+    ASSERT_EQ(expected, component);
+
+    std::vector<int> weak(20000);
+    const int        w = boost::connected_components(c, &weak[0]);
+    relabel_labels(weak);
+    ASSERT_EQ(w, weakly_connected_components(g, component, 4));
+    ASSERT_EQ(weak, component);}
+
+TEST(TestGraphBFS, BFS_Unsigned) {
+    Graph          g;
+    boost_directed b;
+    random_graph(5000, 8000, 8, g, b);
+    BasicGraph<uint32_t> h;
+    std::pair<Graph::edge_iterator, Graph::edge_iterator> p = edges(g);
+    for (; p.first != p.second; ++p.first)
+        add_edge((*p.first).first, (*p.first).second, h);
+    const BasicGraphCSR<uint32_t> c(h);
+
+    std::vector<int>      parent;
+    std::vector<int>      depth;
+    std::vector<uint32_t> u_parent;
+    std::vector<uint32_t> u_depth;
+    ASSERT_EQ(breadth_first_search(g, 7, parent, depth), breadth_first_search(c, 7, u_parent, u_depth, 2));
+    ASSERT_EQ(std::vector<uint32_t>(parent.begin(), parent.end()), u_parent);
+    ASSERT_EQ(std::vector<uint32_t>(depth.begin(), depth.end()), u_depth);
+    ASSERT_EQ(static_cast<uint32_t>(-1), u_depth[std::find(depth.begin(), depth.end(), -1) - depth.begin()]);
+
+    std::vector<int>      component;
+    std::vector<uint32_t> u_component;
+    ASSERT_EQ(weakly_connected_components(g, component), weakly_connected_components(h, u_component, 2));
+    ASSERT_EQ(std::vector<uint32_t>(component.begin(), component.end()), u_component);
+    ASSERT_EQ(strongly_connected_components(g, component), strongly_connected_components(h, u_component, 2));
+    ASSERT_EQ(std::vector<uint32_t>(component.begin(), component.end()), u_component);}
+
+// the largest uint16_t is a vertex, so every count reaches 65536, one more than a vertex_descriptor holds
+TEST(TestGraphBFS, BFS_Largest_Vertex) {
+    typedef BasicGraph<uint16_t> graph_type;
+    graph_type g;
+    add_edge(0,     65535, g);
+    add_edge(65535, 1,     g);
+    add_edge(65534, 65535, g);
+    ASSERT_EQ(65536, num_vertices(g));
+    ASSERT_EQ(65536, std::distance(vertices(g).first, vertices(g).second));
+
+    std::vector<uint16_t> parent;
+    std::vector<uint16_t> depth;
+    ASSERT_EQ(3, breadth_first_search(g, 0, parent, depth, 2));
+    ASSERT_EQ(65535, parent[1]);
+    ASSERT_EQ(2,     depth[1]);
+    std::vector<uint16_t> component;
+    ASSERT_EQ(65533, weakly_connected_components(g, component, 2));
+    ASSERT_EQ(component[0], component[65534]);
+    ASSERT_EQ(65536, strongly_connected_components(g, component, 2));
+    ASSERT_EQ(65535, component[65535]);
+    std::vector<uint16_t> order;
+    ASSERT_TRUE(topological_sort(g, std::back_inserter(order)));
+    ASSERT_EQ(65536, order.size());
+
+    const BasicGraphCSR<uint16_t> c(g);
+    ASSERT_EQ(65536, num_vertices(c));
+    ASSERT_EQ(65536, std::distance(vertices(c).first, vertices(c).second));
+    ASSERT_EQ(3,     std::distance(edges(c).first, edges(c).second));
+    ASSERT_TRUE(save(g, "TestGraph.tmp"));
+    BasicGraphMapped<uint16_t> m("TestGraph.tmp");
+    std::remove("TestGraph.tmp");
+    ASSERT_TRUE(m.is_open());
+    ASSERT_TRUE(m.verify());
+    ASSERT_EQ(65536, num_vertices(m));
+    ASSERT_TRUE(edge(65535, 1, m).second);
+
+    // one below, so that the search holds exactly the largest count a vertex_descriptor can
+    graph_type h;
+    add_edge(0, 65534, h);
+    ASSERT_EQ(2, breadth_first_search(h, 0, parent, depth, 2));
+    ASSERT_EQ(1, depth[65534]);}
+
+// ----------------
+// topological_sort
+// ----------------
+
+/**
+ * true if x holds every vertex of g once and every edge of g goes forward in x
+ */
+template <typename G>
+bool is_topological (const G& g, const std::vector<int>& x) {
+    std::vector<int> position(num_vertices(g), -1);
+    for (std::size_t i = 0; i != x.size(); ++i) {
+        if (position[x[i]] != -1)
+            return false;
+        position[x[i]] = i;}
+    if (x.size() != num_vertices(g))
+        return false;
+    typename G::edge_iterator b = edges(g).first;
+    typename G::edge_iterator e = edges(g).second;
+    for (; b != e; ++b)
+        if (position[source(*b, g)] >= position[target(*b, g)])
+            return false;
+    return true;}
+
+TEST(TestGraphDAG, Topological_Sort_1) {
+    Graph g;
+    add_edge(3, 1, g);
+    add_edge(1, 0, g);
+    add_edge(2, 0, g);
+    add_edge(3, 2, g);
+
+    std::vector<int> x;
+    ASSERT_TRUE(topological_sort(g, std::back_inserter(x)));
+    ASSERT_TRUE(is_topological(g, x));
+    ASSERT_EQ(3, x[0]);
+    ASSERT_EQ(0, x[3]);
+    ASSERT_FALSE(has_cycle(g));
+
+    add_edge(0, 3, g);
+    ASSERT_TRUE(has_cycle(g));
+
+    // in the order the vertices become ready
+    Graph h;
+    add_edge(0, 3, h);
+    add_edge(1, 2, h);
+    std::vector<int> y;
+    ASSERT_TRUE(topological_sort(h, std::back_inserter(y)));
+    ASSERT_EQ(0, y[0]);
+    ASSERT_EQ(1, y[1]);
+    ASSERT_EQ(3, y[2]);
+    ASSERT_EQ(2, y[3]);}
+
+TEST(TestGraphDAG, Topological_Sort_2) {
+    for (int m = 1000; m <= 16000; m *= 4) {
+        Graph          g;
+        boost_directed b;
+        random_graph(2000, m, 4, g, b);
+
+        bool boost_cycle = false;
+        std::vector<boost_directed::vertex_descriptor> y;
+        try {
+            boost::topological_sort(b, std::back_inserter(y));}
+        catch (const boost::not_a_dag&) {
+            boost_cycle = true;}
+
+        std::vector<int> x;
+        ASSERT_EQ(!boost_cycle, topological_sort(g, std::back_inserter(x)));
+        ASSERT_EQ(boost_cycle, has_cycle(GraphCSR(g)));
+        if (!boost_cycle) {
+            ASSERT_TRUE(is_topological(g, x));}}}
+
+TEST(TestGraphDAG, Topological_Sort_3) {
+    Graph g;
+    std::vector<Graph::edge_descriptor> x;
+    for (int v = 0; v != 500000; ++v)
+        x.push_back(std::make_pair(500000 - v, 499999 - v));
+    add_edges(x.begin(), x.end(), g);
+
+    std::vector<int> y;
+    ASSERT_TRUE(topological_sort(g, std::back_inserter(y)));
+    ASSERT_EQ(500000, y.front());
+    ASSERT_EQ(0,      y.back());
+
+    add_edge(0, 500000, g);
+    ASSERT_TRUE(has_cycle(g));}
+
+// --------
+// GraphDAG
+// --------
+
+TEST(TestGraphDAG, DAG_1) {
+    GraphDAG g;
+    ASSERT_TRUE(add_edge(2, 1, g).second);
+    ASSERT_TRUE(add_edge(1, 0, g).second);
+    ASSERT_FALSE(add_edge(1, 0, g).second);
+    ASSERT_FALSE(add_edge(0, 2, g).second);
+    ASSERT_FALSE(add_edge(3, 3, g).second);
+    ASSERT_FALSE(edge(0, 2, g).second);
+
+    ASSERT_EQ(3, num_vertices(g));
+    ASSERT_EQ(2, num_edges(g));
+    ASSERT_TRUE(is_topological(g, topological_order(g)));
+    ASSERT_FALSE(has_cycle(g));}
+
+TEST(TestGraphDAG, DAG_2) {
+    std::mt19937 r(5);
+    std::uniform_int_distribution<int> d(0, 199);
+    GraphDAG g;
+    Graph    h;
+    for (int i = 0; i != 3000; ++i) {
+        const int u = d(r);
+        const int v = d(r);
+        Graph h2 = h;
+        const bool expected = add_edge(u, v, h2).second && !has_cycle(h2);
+        ASSERT_EQ(expected, add_edge(u, v, g).second);
+        if (expected)
+            h = h2;
+        if (i % 100 == 0) {
+            ASSERT_TRUE(is_topological(g, topological_order(g)));}}
+    ASSERT_EQ(num_edges(h), num_edges(g));
+    ASSERT_TRUE(is_topological(g, topological_order(g)));}
+
+TEST(TestGraphDAG, DAG_3) {
+    GraphDAG g;
+    for (int v = 0; v != 100000; ++v)
+        ASSERT_TRUE(add_edge(v, v + 1, g).second);
+    ASSERT_FALSE(add_edge(100000, 0, g).second);
+    ASSERT_TRUE(add_edge(0, 100000, g).second);
+    ASSERT_EQ(0,      topological_order(g).front());
+    ASSERT_EQ(100000, topological_order(g).back());}
+
+TEST(TestGraphDAG, DAG_4) {
+    GraphDAG g;
+    for (int v = 1000; v != 0; --v)
+        ASSERT_TRUE(add_edge(v, v - 1, g).second);
+    ASSERT_FALSE(add_edge(0, 1000, g).second);
+    ASSERT_EQ(1000, topological_order(g).front());
+    ASSERT_EQ(0,    topological_order(g).back());
+    ASSERT_TRUE(is_topological(g, topological_order(g)));}
+
+TEST(TestGraphDAG, DAG_Unsigned) {
+    BasicGraphDAG<uint64_t> g;
+    ASSERT_TRUE(add_edge(2, 1, g).second);
+    ASSERT_TRUE(add_edge(1, 0, g).second);
+    ASSERT_FALSE(add_edge(0, 2, g).second);
+    ASSERT_FALSE(add_edge(3, 3, g).second);
+    ASSERT_EQ(3, num_vertices(g));
+    std::vector<uint64_t> x;
+    ASSERT_TRUE(topological_sort(g, std::back_inserter(x)));
+    ASSERT_EQ(topological_order(g).size(), x.size());
+    ASSERT_EQ(2, topological_order(g).front());}
+
+// ---------------
+// GraphConcurrent
+// ---------------
+
+TEST(TestGraphConcurrent, Concurrent_1) {
+    GraphConcurrent g;
+    ASSERT_TRUE(add_edge(1, 2, g).second);
+    ASSERT_FALSE(add_edge(1, 2, g).second);
+    ASSERT_TRUE(add_edge(1, 0, g).second);
+    ASSERT_TRUE(add_edge(5, 3, g).second);
+    ASSERT_EQ(3, num_edges(g));
+    ASSERT_EQ(6, num_vertices(g));
+
+    GraphSnapshot s(g);
+    ASSERT_EQ(3, num_edges(s));
+    ASSERT_EQ(6, num_vertices(s));
+    ASSERT_TRUE(edge(1, 0, s).second);
+    ASSERT_FALSE(edge(0, 1, s).second);
+    ASSERT_FALSE(edge(9, 1, s).second);
+    std::pair<GraphSnapshot::adjacency_iterator, GraphSnapshot::adjacency_iterator> p = adjacent_vertices(1, s);
+    ASSERT_EQ(2, p.second - p.first);
+    ASSERT_EQ(0, p.first[0]);
+    ASSERT_EQ(2, p.first[1]);
+    ASSERT_EQ(0, adjacent_vertices(4, s).second - adjacent_vertices(4, s).first);
+
+    std::vector<GraphSnapshot::edge_descriptor> x(edges(s).first, edges(s).second);
+    ASSERT_EQ(3, x.size());
+    ASSERT_EQ(std::make_pair(1, 0), x[0]);
+    ASSERT_EQ(std::make_pair(1, 2), x[1]);
+    ASSERT_EQ(std::make_pair(5, 3), x[2]);}
+
+TEST(TestGraphConcurrent, Concurrent_2) {
+    std::vector<Graph::edge_descriptor> x;
+    for (int i = 0; i < 20000; ++i)
+        x.push_back(std::make_pair(i % 100, (i * 31) % 211));
+    Graph           g;
+    GraphConcurrent h;
+    add_edges(x.begin(), x.end(), g, 1);
+    ASSERT_EQ(num_edges(g), add_edges(x.begin(), x.end(), h));
+    ASSERT_EQ(0, add_edges(x.begin(), x.end(), h));
+
+    GraphSnapshot s(h);
+    ASSERT_EQ(num_vertices(g), num_vertices(s));
+    ASSERT_EQ(num_edges(g), num_edges(s));
+    ASSERT_TRUE(std::equal(edges(g).first, edges(g).second, edges(s).first));
+
+    std::vector<int> parent;
+    std::vector<int> depth;
+    std::vector<int> parent_s;
+    std::vector<int> depth_s;
+    ASSERT_EQ(breadth_first_search(g, 0, parent, depth, 1), breadth_first_search(s, 0, parent_s, depth_s, 1));
+    ASSERT_EQ(depth, depth_s);}
+
+TEST(TestGraphConcurrent, Concurrent_Snapshot) {
+    GraphConcurrent g(4, 4);
+    for (int v = 1; v != 100; ++v)
+        add_edge(0, v, g);
+    GraphSnapshot s(g);
+    for (int v = 100; v != 10000; ++v) {
+        add_edge(0, v, g);
+        add_edge(v, 0, g);}
+    GraphSnapshot t(g);
+    ASSERT_EQ(99,    num_edges(s));
+    ASSERT_EQ(100,   num_vertices(s));
+    ASSERT_EQ(99,    adjacent_vertices(0, s).second - adjacent_vertices(0, s).first);
+    ASSERT_FALSE(edge(100, 0, s).second);
+    ASSERT_EQ(19899, num_edges(t));
+    ASSERT_EQ(9999,  adjacent_vertices(0, t).second - adjacent_vertices(0, t).first);
+    ASSERT_LT(s.stamp(), t.stamp());
+
+    GraphSnapshot u(std::move(s));
+    ASSERT_EQ(99, num_edges(u));}
+
+TEST(TestGraphConcurrent, Concurrent_Stress) {
+    const int         n_writers = 4;
+    const int         n_edges   = 5000;
+    const int         n         = 2000;
+    GraphConcurrent   g(16, 4);
+    std::atomic<int>  writing(n_writers);
+    std::atomic<bool> failed(false);
+
+    std::vector<std::vector<Graph::edge_descriptor> > x(n_writers);
+    for (int t = 0; t != n_writers; ++t) {
+        std::mt19937                       r(t);
+        std::uniform_int_distribution<int> d(0, n - 1);
+        for (int i = 0; i != n_edges; ++i)
+            x[t].push_back(std::make_pair(d(r) % (n / 8), d(r)));}
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t != n_writers; ++t)
+        threads.push_back(std::thread([&, t] () {
+            // half one edge at a time, half in batches
+            for (int i = 0; i != n_edges / 2; ++i)
+                add_edge(x[t][i].first, x[t][i].second, g);
+            for (int i = n_edges / 2; i < n_edges; i += 100)
+                add_edges(x[t].begin() + i, x[t].begin() + std::min(i + 100, n_edges), g);
+            --writing;}));
+    for (int t = 0; t != 2; ++t)
+        threads.push_back(std::thread([&] () {
+            GraphSnapshot::edges_size_type last = 0;
+            while (writing.load() != 0) {
+                GraphSnapshot                  s(g);
+                GraphSnapshot::edges_size_type m = 0;
+                for (GraphSnapshot::vertices_size_type u = 0; u != num_vertices(s); ++u) {
+                    std::pair<GraphSnapshot::adjacency_iterator, GraphSnapshot::adjacency_iterator> p = adjacent_vertices(u, s);
+                    for (GraphSnapshot::adjacency_iterator i = p.first; i != p.second; ++i)
+                        if ((static_cast<GraphSnapshot::vertices_size_type>(*i) >= num_vertices(s)) || ((i != p.first) && !(i[-1] < *i)))
+                            failed = true;
+                    m += p.second - p.first;}
+                // a snapshot does not change under later writes
+                if ((m < last) || (m != num_edges(s)) || (m != static_cast<GraphSnapshot::edges_size_type>(std::distance(edges(s).first, edges(s).second))))
+                    failed = true;
+                last = m;}}));
+    for (std::size_t t = 0; t != threads.size(); ++t)
+        threads[t].join();
+    ASSERT_FALSE(failed.load());
+
+    Graph h;
+    for (int t = 0; t != n_writers; ++t)
+        add_edges(x[t].begin(), x[t].end(), h, 1);
+    GraphSnapshot s(g);
+    ASSERT_EQ(num_edges(h), num_edges(g));
+    ASSERT_EQ(num_edges(h), num_edges(s));
+    ASSERT_EQ(num_vertices(h), num_vertices(s));
+    ASSERT_TRUE(std::equal(edges(h).first, edges(h).second, edges(s).first));}
+
+TEST(TestGraphConcurrent, Concurrent_Hub) {
+    std::vector<int> x;
+    for (int v = 1; v != 80001; ++v)
+        x.push_back(v);
+    std::shuffle(x.begin(), x.end(), std::mt19937(5));
+    GraphConcurrent g(4, 4);
+    for (int i = 0; i != 40000; ++i)
+        add_edge(0, x[i], g);
+    GraphSnapshot s(g);
+    for (int i = 40000; i != 80000; ++i)
+        add_edge(0, x[i], g);
+    GraphSnapshot t(g);
+
+    std::vector<int> a(x.begin(), x.begin() + 40000);
+    std::sort(a.begin(), a.end());
+    std::sort(x.begin(), x.end());
+    ASSERT_EQ(40000, num_edges(s));
+    ASSERT_EQ(a, std::vector<int>(adjacent_vertices(0, s).first, adjacent_vertices(0, s).second));
+    ASSERT_EQ(x, std::vector<int>(adjacent_vertices(0, t).first, adjacent_vertices(0, t).second));
+    ASSERT_TRUE(edge(0, x[12345], t).second);
+    ASSERT_FALSE(edge(0, 80001, t).second);
+
+    const GraphCSR c(t);
+    ASSERT_EQ(80000, num_edges(c));
+    ASSERT_TRUE(std::equal(edges(c).first, edges(c).second, edges(t).first));}
+
+TEST(TestGraphConcurrent, Concurrent_Shards) {
+    ASSERT_EQ(1,    GraphConcurrent(0).shards());
+    ASSERT_EQ(1,    GraphConcurrent(1).shards());
+    ASSERT_EQ(256,  GraphConcurrent().shards());
+    ASSERT_EQ(2048, GraphConcurrent(1536).shards());
+
+    GraphConcurrent g(1536, 4);
+    for (int v = 0; v != 5000; ++v)
+        add_edge(v, (v * 7) % 5000, g);
+    GraphSnapshot s(g);
+    ASSERT_EQ(5000, num_edges(s));
+    for (int v = 0; v != 5000; ++v)
+        ASSERT_TRUE(edge(v, (v * 7) % 5000, s).second);}
+
+TEST(TestGraphConcurrent, Concurrent_Shared_Snapshot) {
+    GraphConcurrent g(4, 4);
+    for (int i = 0; i != 20000; ++i)
+        add_edge(i % 50, (i * 7919) % 10007, g);
+    GraphSnapshot s(g);
+
+    // the runs of each vertex are merged by whichever thread reads them first
+    std::vector<std::vector<int> > x(4);
+    std::vector<std::thread>       threads;
+    for (int t = 0; t != 4; ++t)
+        threads.push_back(std::thread([&, t] () {
+            for (int u = 0; u != 50; ++u) {
+                std::pair<GraphSnapshot::adjacency_iterator, GraphSnapshot::adjacency_iterator> p = adjacent_vertices(u, s);
+                x[t].insert(x[t].end(), p.first, p.second);}}));
+    for (std::size_t t = 0; t != threads.size(); ++t)
+        threads[t].join();
+    ASSERT_EQ(20000, x[0].size());
+    for (int t = 1; t != 4; ++t)
+        ASSERT_EQ(x[0], x[t]);}
+
+TEST(TestGraphConcurrent, Concurrent_Unsigned) {
+    BasicGraphConcurrent<uint64_t> g(4, 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t != 4; ++t)
+        threads.push_back(std::thread([&, t] () {
+            for (uint64_t i = t; i < 20000; i += 4)
+                add_edge(i % 1000, (i * 13) % 1000, g);}));
+    for (std::size_t t = 0; t != threads.size(); ++t)
+        threads[t].join();
+
+    BasicGraphSnapshot<uint64_t> s(g);
+    BasicGraph<uint64_t>         h;
+    for (uint64_t i = 0; i != 20000; ++i)
+        add_edge(i % 1000, (i * 13) % 1000, h);
+    ASSERT_EQ(num_edges(h), num_edges(s));
+    const BasicGraphCSR<uint64_t> c(s);
+    ASSERT_TRUE(std::equal(edges(h).first, edges(h).second, edges(c).first));}
+
+// vertices past the 32 segments of heads are refused, not written past them
+TEST(TestGraphConcurrent, Concurrent_Max_Vertices) {
+    const uint64_t max = (uint64_t(1) << 32) - 1;
+    BasicGraphConcurrent<uint64_t> g(4, 4);
+    ASSERT_FALSE(add_edge(0,   max,                g).second);
+    ASSERT_FALSE(add_edge(max, 0,                  g).second);
+    ASSERT_FALSE(add_edge(0,   uint64_t(1) << 40,  g).second);
+    ASSERT_EQ(0, num_vertices(g));
+
+    std::vector<std::pair<uint64_t, uint64_t> > x;
+    x.push_back(std::make_pair(1,   2));
+    x.push_back(std::make_pair(max, 2));
+    x.push_back(std::make_pair(2,   ~uint64_t(0)));
+    x.push_back(std::make_pair(2,   3));
+    ASSERT_EQ(2, add_edges(x.begin(), x.end(), g));
+    ASSERT_EQ(4, num_vertices(g));
+    BasicGraphSnapshot<uint64_t> s(g);
+    ASSERT_EQ(2, num_edges(s));
+    ASSERT_TRUE(edge(2, 3, s).second);}
+
+// ---------
+// intersect
+// ---------
+
+// sorted, distinct values below m
+template <typename T>
+std::vector<T> random_set (std::mt19937& r, int n, int m) {
+    std::uniform_int_distribution<int> d(0, m - 1);
+    std::vector<T> x;
+    for (int i = 0; i != n; ++i)
+        x.push_back(d(r));
+    std::sort(x.begin(), x.end());
+    x.erase(std::unique(x.begin(), x.end()), x.end());
+    return x;}
+
+// the vector kernels that apply to T, those for 32-bit elements that the CPU can run
+template <typename T>
+struct simd_kernels {
+    static void add (std::vector<std::size_t (*) (const T*, std::size_t, const T*, std::size_t, T*)>&)
+        {}};
+
+#ifdef GRAPH_SIMD
+template <typename T>
+struct simd_kernels_32 {
+    static void add (std::vector<std::size_t (*) (const T*, std::size_t, const T*, std::size_t, T*)>& kernels) {
+        kernels.push_back(intersect_sse<T>);
+        if (has_avx2())
+            kernels.push_back(intersect_avx2<T>);}};
+
+template <>
+struct simd_kernels<int> : simd_kernels_32<int> {};
+
+template <>
+struct simd_kernels<uint32_t> : simd_kernels_32<uint32_t> {};
+#endif
+
+// every kernel against std::set_intersection, counting and writing
+template <typename T>
+void check_intersect (const std::vector<T>& a, const std::vector<T>& b) {
+    typedef std::size_t (*kernel_type) (const T*, std::size_t, const T*, std::size_t, T*);
+    std::vector<T> e;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(e));
+    std::vector<kernel_type> kernels;
+    kernels.push_back(intersect_scalar<T>);
+    kernels.push_back(intersect_gallop<T>);
+    kernels.push_back(intersect<T>);
+    simd_kernels<T>::add(kernels);
+    for (std::size_t i = 0; i != kernels.size(); ++i) {
+        std::vector<T> x(std::min(a.size(), b.size()));
+        ASSERT_EQ(e.size(), kernels[i](a.data(), a.size(), b.data(), b.size(), x.data()));
+        ASSERT_TRUE(std::equal(e.begin(), e.end(), x.begin()));
+        ASSERT_EQ(e.size(), kernels[i](b.data(), b.size(), a.data(), a.size(), 0));}}
+
+TEST(TestGraphIntersect, Intersect_1) {
+    std::vector<int> a;
+    std::vector<int> b;
+    check_intersect(a, b);
+    for (int i = 0; i != 40; ++i)
+        a.push_back(2 * i);
+    check_intersect(a, b);
+    check_intersect(a, a);
+    for (int i = 0; i != 40; ++i)
+        b.push_back(2 * i + 1);
+    check_intersect(a, b);
+    b.push_back(78);
+    check_intersect(a, b);}
+
+TEST(TestGraphIntersect, Intersect_2) {
+    std::mt19937 r(0);
+    for (int i = 0; i != 500; ++i) {
+        const int m = (i % 3 == 0) ? 100 : 5000;
+        check_intersect(random_set<int>(r, i % 97, m), random_set<int>(r, (i * 7) % 131, m));
+        check_intersect(random_set<uint32_t>(r, i % 11, m), random_set<uint32_t>(r, 40 * (i % 11), m));
+        check_intersect(random_set<uint64_t>(r, i % 97, m), random_set<uint64_t>(r, (i * 7) % 131, m));}}
+
+TEST(TestGraphIntersect, Intersect_3) {
+    std::vector<int> a;
+    std::vector<int> b;
+    for (int i = 0; i != 20; ++i) {
+        a.push_back(-100 + 10 * i);
+        b.push_back(-95 + 5 * i);}
+    check_intersect(a, b);
+    std::vector<int> x;
+    ASSERT_EQ(10, intersection_size(a.data(), a.data() + a.size(), b.data(), b.data() + b.size()));
+    ASSERT_EQ(10, intersection_size(a.begin(), a.end(), b.begin(), b.end()));
+    intersection(a.data(), a.data() + a.size(), b.data(), b.data() + b.size(), std::back_inserter(x));
+    ASSERT_EQ(10, x.size());
+    ASSERT_EQ(-90, x.front());
+    ASSERT_EQ(0,   x.back());}
+
+// ----------------
+// common_neighbors
+// ----------------
+
+TEST(TestGraphIntersect, Common_Neighbors_1) {
+    Graph g;
+    for (int v = 1; v != 20; ++v) {
+        add_edge(0, v, g);
+        if (v % 2 == 0)
+            add_edge(20, v, g);}
+    add_edge(20, 21, g);
+
+    ASSERT_EQ(9, num_common_neighbors(0, 20, g));
+    ASSERT_EQ(0, num_common_neighbors(0, 5, g));
+    std::vector<int> x;
+    common_neighbors(0, 20, g, std::back_inserter(x));
+    ASSERT_EQ(9,  x.size());
+    ASSERT_EQ(2,  x.front());
+    ASSERT_EQ(18, x.back());
+    ASSERT_DOUBLE_EQ(9.0 / 20.0, jaccard(0, 20, g));
+    ASSERT_DOUBLE_EQ(1.0, jaccard(0, 0, g));
+    ASSERT_DOUBLE_EQ(0.0, jaccard(1, 2, g));}
+
+TEST(TestGraphIntersect, Common_Neighbors_2) {
+    boost_directed b;
+    Graph          g;
+    random_graph(300, 6000, 4, g, b);
+    const GraphCSR c(g);
+    std::vector<double> j;
+    std::vector<double> jb;
+    edge_jaccard(g, j, 4);
+    edge_jaccard(b, jb, 2);
+    ASSERT_EQ(num_edges(g), j.size());
+    ASSERT_EQ(j, jb);
+
+    std::size_t i = 0;
+    for (std::pair<Graph::edge_iterator, Graph::edge_iterator> p = edges(g); p.first != p.second; ++p.first, ++i) {
+        const int u = source(*p.first, g);
+        const int v = target(*p.first, g);
+        ASSERT_EQ(num_common_neighbors(u, v, b), num_common_neighbors(u, v, g));
+        ASSERT_EQ(num_common_neighbors(u, v, c), num_common_neighbors(u, v, g));
+        ASSERT_DOUBLE_EQ(jaccard(u, v, g), j[i]);}}
+
+// the CSR adjacency is a pointer range, so it takes the pointer overloads, which go through intersect
+TEST(TestGraphIntersect, Common_Neighbors_3) {
+    boost_directed b;
+    Graph          g;
+    random_graph(200, 8000, 6, g, b);
+    const GraphCSR c(g);
+    ASSERT_TRUE((std::is_same<GraphCSR::adjacency_iterator, const int*>::value));
+    ASSERT_EQ(adjacent_vertices(0, c).second, adjacent_vertices(1, c).first);
+
+    std::vector<int> x(num_vertices(g));
+    std::vector<int> y;
+    for (int u = 0; u != 20; ++u)
+        for (int v = 0; v < 200; v += 7) {
+            const std::pair<GraphCSR::adjacency_iterator, GraphCSR::adjacency_iterator> p = adjacent_vertices(u, c);
+            const std::pair<GraphCSR::adjacency_iterator, GraphCSR::adjacency_iterator> q = adjacent_vertices(v, c);
+            const std::size_t k = intersect(p.first, p.second - p.first, q.first, q.second - q.first);
+            ASSERT_EQ(k, num_common_neighbors(u, v, c));
+            ASSERT_EQ(x.data() + k, common_neighbors(u, v, c, x.data()));
+            y.clear();
+            common_neighbors(u, v, g, std::back_inserter(y));
+            ASSERT_EQ(y, std::vector<int>(x.begin(), x.begin() + k));}}
+
+// ---------
+// triangles
+// ---------
+
+TEST(TestGraphIntersect, Triangles_1) {
+    Graph g;
+    ASSERT_EQ(0, triangle_count(g));
+    add_edge(0, 1, g);
+    add_edge(1, 2, g);
+    add_edge(2, 0, g);
+    add_edge(0, 2, g);
+    add_edge(2, 2, g);
+    add_edge(2, 3, g);
+    add_edge(3, 0, g);
+    std::vector<uint64_t> c;
+    ASSERT_EQ(2, triangle_count(g));
+    ASSERT_EQ(2, triangle_counts(g, c));
+    ASSERT_EQ(2, c[0]);
+    ASSERT_EQ(1, c[1]);
+    ASSERT_EQ(2, c[2]);
+    ASSERT_EQ(1, c[3]);}
+
+TEST(TestGraphIntersect, Triangles_2) {
+    boost_directed b;
+    Graph          g;
+    random_graph(120, 2500, 5, g, b);
+
+    // every triple, against the adjacency matrix
+    const int n = num_vertices(g);
+    std::vector<std::vector<bool> > m(n, std::vector<bool>(n, false));
+    for (std::pair<Graph::edge_iterator, Graph::edge_iterator> p = edges(g); p.first != p.second; ++p.first)
+        m[(*p.first).first][(*p.first).second] = m[(*p.first).second][(*p.first).first] = true;
+    uint64_t              s = 0;
+    std::vector<uint64_t> expected(n, 0);
+    for (int u = 0; u != n; ++u)
+        for (int v = u + 1; v != n; ++v)
+            for (int w = v + 1; w != n; ++w)
+                if (m[u][v] && m[v][w] && m[u][w]) {
+                    ++s;
+                    ++expected[u];
+                    ++expected[v];
+                    ++expected[w];}
+
+    std::vector<uint64_t> c;
+    std::vector<uint64_t> cb;
+    ASSERT_EQ(s, triangle_count(g, 1));
+    ASSERT_EQ(s, triangle_count(g, 4));
+    ASSERT_EQ(s, triangle_count(b, 2));
+    ASSERT_EQ(s, triangle_counts(g, c, 4));
+    ASSERT_EQ(s, triangle_counts(b, cb, 2));
+    ASSERT_EQ(expected, c);
+    ASSERT_EQ(expected, cb);}